@@ -0,0 +1,223 @@
+#include "Animation.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "BoundedQueue.hpp"
+#include "Image.hpp"
+
+JuliaProperties InterpolateKeyframes(const std::vector<Keyframe>& keyframes, double time)
+{
+	if (keyframes.empty())
+		throw std::runtime_error("An animation needs at least one keyframe");
+
+	if (time <= keyframes.front().time)
+		return keyframes.front().properties;
+
+	if (time >= keyframes.back().time)
+		return keyframes.back().properties;
+
+	size_t next = 1;
+	while (keyframes[next].time < time)
+		next++;
+
+	const Keyframe& from = keyframes[next - 1];
+	const Keyframe& to = keyframes[next];
+	double t = (time - from.time) / (to.time - from.time);
+
+	auto mix = [t](double a, double b) { return a + (b - a) * t; };
+
+	const JuliaProperties& a = from.properties;
+	const JuliaProperties& b = to.properties;
+	JuliaProperties result = a;
+
+	double center = mix(0.5 * (a.xBounds[0] + a.xBounds[1]), 0.5 * (b.xBounds[0] + b.xBounds[1]));
+	double widthA = a.xBounds[1] - a.xBounds[0];
+	double widthB = b.xBounds[1] - b.xBounds[0];
+	double width = widthA * std::pow(widthB / widthA, t);
+
+	result.xBounds[0] = center - 0.5 * width;
+	result.xBounds[1] = center + 0.5 * width;
+	result.yCenter = mix(a.yCenter, b.yCenter);
+	result.c[0] = (float)mix(a.c[0], b.c[0]);
+	result.c[1] = (float)mix(a.c[1], b.c[1]);
+	result.maxIterations = (uint32_t)std::round(mix(a.maxIterations, b.maxIterations));
+	result.iterationColorCutoff = (float)mix(a.iterationColorCutoff, b.iterationColorCutoff);
+
+	return result;
+}
+
+std::string FormatFramePath(const std::string& pattern, uint32_t index)
+{
+	// Only "%d" and "%0<width>d" are supported, the pattern comes from the
+	// user and can't go to printf directly
+	size_t start = pattern.find('%');
+	if (start == std::string::npos)
+		throw std::runtime_error("Output pattern needs a frame number like %05d: " + pattern);
+
+	size_t end = start + 1;
+	bool zeroPad = end < pattern.size() && pattern[end] == '0';
+	while (end < pattern.size() && std::isdigit((unsigned char)pattern[end]))
+		end++;
+
+	if (end >= pattern.size() || pattern[end] != 'd' || pattern.find('%', end) != std::string::npos)
+		throw std::runtime_error("Output pattern needs exactly one frame number like %05d: " + pattern);
+
+	size_t width = end > start + 1 ? std::stoul(pattern.substr(start + 1, end - start - 1)) : 0;
+
+	std::string number = std::to_string(index);
+	if (number.size() < width)
+		number.insert(0, width - number.size(), zeroPad ? '0' : ' ');
+
+	return pattern.substr(0, start) + number + pattern.substr(end + 1);
+}
+
+// A frame on its way through the pipeline
+struct AnimationFrame
+{
+	uint32_t index;
+	JuliaProperties properties;
+	uint32_t width, height;
+	std::vector<uint32_t> iterations;
+	std::vector<uint8_t> data;
+};
+
+AnimationStats RenderAnimation(CpuEngine& engine, const std::vector<Keyframe>& keyframes, const AnimationSettings& settings)
+{
+	std::string extension = settings.outputPattern.substr(std::min(settings.outputPattern.size(), settings.outputPattern.rfind('.')));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+	bool png = extension == ".png";
+	if (!png && extension != ".ppm")
+		throw std::runtime_error("Unsupported output format, use .png or .ppm: " + settings.outputPattern);
+
+	// Fail before any work is done
+	FormatFramePath(settings.outputPattern, 0);
+	if (keyframes.empty())
+		throw std::runtime_error("An animation needs at least one keyframe");
+
+	size_t capacity = std::max(settings.queueSize, 1u);
+	BoundedQueue<AnimationFrame> computed(capacity), colorized(capacity), encoded(capacity);
+
+	AnimationStats stats = {};
+
+	// The first error stops the whole pipeline
+	std::mutex errorMutex;
+	std::exception_ptr error;
+	auto fail = [&](std::exception_ptr exception)
+	{
+		{
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if (!error)
+				error = exception;
+		}
+
+		computed.Close();
+		colorized.Close();
+		encoded.Close();
+	};
+
+	using Clock = std::chrono::steady_clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+	// Every stage pops from one queue, works and pushes into the next. Once
+	// its input is closed and empty, it closes its output.
+	auto stage = [&](BoundedQueue<AnimationFrame>& input, BoundedQueue<AnimationFrame>* output, double& busy, auto work)
+	{
+		return std::thread([&, output, work]()
+		{
+			try
+			{
+				AnimationFrame frame;
+				while (input.Pop(frame))
+				{
+					auto start = Clock::now();
+					work(frame);
+					busy += elapsed(start);
+
+					if (output && !output->Push(std::move(frame)))
+						break;
+				}
+			}
+			catch (...)
+			{
+				fail(std::current_exception());
+			}
+
+			if (output)
+				output->Close();
+		});
+	};
+
+	auto wallStart = Clock::now();
+
+	std::thread colorizer = stage(computed, &colorized, stats.colorizeMilliseconds,
+		[](AnimationFrame& frame)
+		{
+			ColorizeIterations(frame.properties, frame.iterations, frame.data);
+			frame.iterations = std::vector<uint32_t>();
+		}
+	);
+
+	std::thread encoder = stage(colorized, &encoded, stats.encodeMilliseconds,
+		[png](AnimationFrame& frame)
+		{
+			frame.data = png ? EncodePNG(frame.width, frame.height, frame.data) : EncodePPM(frame.width, frame.height, frame.data);
+		}
+	);
+
+	std::thread writer = stage(encoded, nullptr, stats.writeMilliseconds,
+		[&settings](AnimationFrame& frame)
+		{
+			WriteFile(FormatFramePath(settings.outputPattern, frame.index), frame.data);
+		}
+	);
+
+	// The engine has threads of its own, computing stays on this one
+	try
+	{
+		double first = keyframes.front().time;
+		double last = keyframes.back().time;
+
+		for (uint32_t i = 0; i < settings.frameCount; i++)
+		{
+			double time = settings.frameCount > 1 ? first + (last - first) * i / (settings.frameCount - 1) : first;
+
+			AnimationFrame frame;
+			frame.index = i;
+			frame.properties = InterpolateKeyframes(keyframes, time);
+
+			auto start = Clock::now();
+			engine.CalculateJuliaSet(frame.properties);
+			frame.width = engine.GetWidth();
+			frame.height = engine.GetHeight();
+			frame.iterations = engine.GetIterations();
+			stats.computeMilliseconds += elapsed(start);
+
+			if (!computed.Push(std::move(frame)))
+				break;
+		}
+	}
+	catch (...)
+	{
+		fail(std::current_exception());
+	}
+
+	computed.Close();
+	colorizer.join();
+	encoder.join();
+	writer.join();
+
+	stats.wallMilliseconds = elapsed(wallStart);
+
+	if (error)
+		std::rethrow_exception(error);
+
+	return stats;
+}
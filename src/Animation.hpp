@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuEngine.hpp"
+#include "JuliaProperties.hpp"
+
+struct Keyframe
+{
+	double time;
+	JuliaProperties properties;
+};
+
+// Properties at a point in time between keyframes, which have to be sorted
+// by time. The view width is interpolated exponentially so zooms run at a
+// constant speed. c is interpolated in whatever coordinates the keyframe
+// uses, so with polar coordinates a change of phi sweeps c along a circle.
+// Settings that can't be interpolated come from the earlier keyframe.
+JuliaProperties InterpolateKeyframes(const std::vector<Keyframe>& keyframes, double time);
+
+struct AnimationSettings
+{
+	uint32_t frameCount;
+
+	// printf style path with one integer conversion, e.g. "frame_%05d.png".
+	// The extension picks the format, .png or .ppm.
+	std::string outputPattern;
+
+	// Frames that can wait between two stages
+	uint32_t queueSize;
+};
+
+struct AnimationStats
+{
+	double wallMilliseconds;
+
+	// Time every stage spent working, summed over all frames. With the
+	// stages overlapping, the wall time ends up close to the largest one
+	// instead of their sum.
+	double computeMilliseconds;
+	double colorizeMilliseconds;
+	double encodeMilliseconds;
+	double writeMilliseconds;
+};
+
+// Replaces the integer conversion in the pattern with the frame index
+std::string FormatFramePath(const std::string& pattern, uint32_t index);
+
+// Renders the frames evenly spread from the first to the last keyframe and
+// writes them to files. Computing, coloring, encoding and writing run on
+// threads of their own, connected by bounded queues, so one frame is
+// encoded and written while the next is being calculated.
+// Throws the first error of any stage.
+AnimationStats RenderAnimation(CpuEngine& engine, const std::vector<Keyframe>& keyframes, const AnimationSettings& settings);
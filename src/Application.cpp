@@ -3,16 +3,27 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <algorithm>
+
+#include "Palette.hpp"
+#include "Atlas.hpp"
 
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
 Application::Application() :
-	window(new Window(1280, 720, "Julia Sets")), canvas(nullptr)
+	window(new Window(1280, 720, "Julia Sets")), canvas(nullptr), imguiTimer(nullptr), precisionTimings{ 0.0, 0.0, 0.0 }, hasPrecisionTimings(false), lastInteraction(-1.0), atlasGrid(16)
 {
 	// Make the window's context the current one
 	window->MakeContextCurrent();
 
+	// Sync to the monitor, so an idle window doesn't redraw as fast as it can
+	glfwSwapInterval(1);
+
 	// Load OpenGL functions
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
@@ -23,6 +34,7 @@ Application::Application() :
 	glViewport(0, 0, 1280, 720);
 
 	canvas = new Canvas();
+	imguiTimer = new GpuTimer("ImGui");
 
 	// Set up ImGUI
 	IMGUI_CHECKVERSION();
@@ -38,6 +50,7 @@ Application::Application() :
 	data.lastMousePos = { 0.0, 0.0 };
 	data.mouseDelta = { 0.0, 0.0 };
 	data.wheel = { 0.0, 0.0 };
+	data.panRemainder = { 0.0, 0.0 };
 
 	// set user data pointer and install callbacks
 	GLFWwindow* nativeHandle = window->GetHandle();
@@ -60,6 +73,8 @@ Application::Application() :
 
 Application::~Application()
 {
+	delete imguiTimer;
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -69,7 +84,12 @@ void Application::Launch()
 {
 	while (!window->ShouldClose())
 	{
-		// Recalculate the julia set
+		// GPU timings of earlier frames that are ready by now
+		canvas->GetComputeTimer().Collect();
+		canvas->GetRenderTimer().Collect();
+		imguiTimer->Collect();
+
+		// Recalculate the julia set, if any of its properties changed
 		canvas->CalculateJuliaSet();
 
 		glfwPollEvents();
@@ -98,8 +118,16 @@ void Application::Launch()
 
 		ImGui::SliderInt("Max Iterations", (int*)&props.maxIterations, 10, 1000);
 		ImGui::SliderFloat("Color Threshold", &props.iterationColorCutoff, 10, 1000);
+
+		std::vector<const char*> paletteNames;
+		for (const Palette& palette : GetPalettes())
+			paletteNames.push_back(palette.name.c_str());
+		ImGui::Combo("Palette", (int*)&props.palette, paletteNames.data(), (int)paletteNames.size());
+
 		ImGui::SliderInt("Texture Width", (int*)&props.textureWidth, 480, 2560);
 
+		ImGui::Checkbox("Detect attracting cycles", &props.periodicityCheck);
+
 		if (ImGui::Button(props.isPolar ? "Polar" : "Cartesian"))
 			props.isPolar = !props.isPolar;
 
@@ -114,22 +142,83 @@ void Application::Launch()
 			ImGui::SliderFloat("c (phi)", &props.c[1], 0, 3.1415926535f * 2.0f);
 		}
 
+		// Thumbnails over the c-plane, clicking one picks its c
+		ImGui::SliderInt("Atlas grid", &atlasGrid, 4, 32);
+		if (ImGui::Button("Render c atlas"))
+		{
+			uint32_t thumbnailWidth = std::max(32u, props.textureWidth / (uint32_t)atlasGrid);
+			canvas->CalculateAtlas(MakeCGrid(atlasGrid, atlasGrid, -1.5, 1.5, -1.5, 1.5), atlasGrid, thumbnailWidth);
+			canvas->SetShowAtlas(true);
+		}
+		if (canvas->GetShowAtlas())
+		{
+			ImGui::SameLine();
+			if (ImGui::Button("Back to the view"))
+				canvas->SetShowAtlas(false);
+		}
+
+		bool panReuse = canvas->GetPanReuse();
+		if (ImGui::Checkbox("Reuse pixels when panning", &panReuse))
+			canvas->SetPanReuse(panReuse);
+
+		bool resumeIterations = canvas->GetResumeIterations();
+		if (ImGui::Checkbox("Resume when raising max iterations", &resumeIterations))
+			canvas->SetResumeIterations(resumeIterations);
+
+		bool symmetry = canvas->GetSymmetry();
+		if (ImGui::Checkbox("Use z -> -z symmetry", &symmetry))
+			canvas->SetSymmetry(symmetry);
+
+		bool tileCache = canvas->GetTileCache();
+		if (ImGui::Checkbox("Cache tiles", &tileCache))
+			canvas->SetTileCache(tileCache);
+
+		bool dynamicResolution = canvas->GetDynamicResolution();
+		if (ImGui::Checkbox("Lower resolution while moving", &dynamicResolution))
+			canvas->SetDynamicResolution(dynamicResolution);
+
+		float targetFrameTime = canvas->GetTargetFrameTime();
+		if (ImGui::SliderFloat("Target compute time (ms)", &targetFrameTime, 2.0f, 50.0f))
+			canvas->SetTargetFrameTime(targetFrameTime);
+
+		ImGui::Text("Render width - %u", canvas->GetRenderWidth());
+		if (canvas->GetPendingSlices() > 0)
+			ImGui::Text("Calculating - %u slices left", (unsigned)canvas->GetPendingSlices());
+
+		TileCacheStats cacheStats = canvas->GetTileCacheStats();
+		ImGui::Text("Tile cache - %llu memory hits, %llu disk hits, %llu misses", (unsigned long long)cacheStats.memoryHits,
+			(unsigned long long)cacheStats.diskHits, (unsigned long long)cacheStats.misses);
+
 		ImGui::Separator();
 
 		// Danger zone
 		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.1f, 0.1f, 1.0f));
-		ImGui::TextWrapped("Clicking the following button will set the compute shader precision to double. Depending on the other parameters this can lead to an extremely expensive workload that will lag the app in the best case, or timeout your GPU in the worst case.");
+		ImGui::TextWrapped("Setting the compute shader precision to double can lead to an extremely expensive workload. It is calculated in slices spread over several frames, so the image builds up slowly instead of timing out the GPU. Double-float emulates almost the same precision with pairs of floats and is usually a lot cheaper on consumer GPUs.");
 		ImGui::PopStyleColor();
 
-		ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(1.0f, 0.25f, 0.25f, 1.0f));
-		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(1.0f, 0.35f, 0.35f, 1.0f));
-		ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(1.0f, 0.1f, 0.1f, 1.0f));
-		if (ImGui::Button(props.doublePrecision ? "Double Precision" : "Single Precision"))
-			props.doublePrecision = !props.doublePrecision;
+		const char* precisionNames[] = { "Single", "Double-float", "Double" };
+		ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(1.0f, 0.25f, 0.25f, 1.0f));
+		ImGui::PushStyleColor(ImGuiCol_FrameBgHovered, ImVec4(1.0f, 0.35f, 0.35f, 1.0f));
+		ImGui::PushStyleColor(ImGuiCol_FrameBgActive, ImVec4(1.0f, 0.1f, 0.1f, 1.0f));
+		ImGui::Combo("Precision", (int*)&props.precision, precisionNames, 3);
 		ImGui::PopStyleColor();
 		ImGui::PopStyleColor();
 		ImGui::PopStyleColor();
 
+		// Runs every precision once at the current view, which stalls the
+		// app for a moment
+		if (ImGui::Button("Benchmark precisions"))
+		{
+			precisionTimings = canvas->BenchmarkPrecisions(3);
+			hasPrecisionTimings = true;
+		}
+
+		if (hasPrecisionTimings)
+		{
+			for (int i = 0; i < 3; i++)
+				ImGui::Text("%s: %.2f ms", precisionNames[i], precisionTimings[i]);
+		}
+
 
 		ImGui::Separator();
 
@@ -137,6 +226,38 @@ void Application::Launch()
 		ImGui::Text("Max group sizes - x: %i, y: %i, z: %i", workProps.groupSize[0], workProps.groupSize[1], workProps.groupSize[2]);
 		ImGui::Text("Max invocations - %i", workProps.maxInvocations);
 
+		const int* groupSize = canvas->GetWorkGroupSize();
+		ImGui::Text("Work group size - %i x %i", groupSize[0], groupSize[1]);
+		if (ImGui::Button("Retune work group size"))
+			canvas->TuneWorkGroupSize();
+
+		ImGui::Separator();
+
+		// GPU time of the last frames, newest on the right. Compute only
+		// gets new samples when something was calculated.
+		std::vector<const GpuTimer*> timers = { &canvas->GetComputeTimer(), &canvas->GetRenderTimer(), imguiTimer };
+		for (const GpuTimer* timer : timers)
+		{
+			char overlay[32];
+			snprintf(overlay, sizeof(overlay), "%.3f ms", timer->GetLatest());
+
+			const std::vector<float>& history = timer->GetHistory();
+			ImGui::PlotHistogram(timer->GetName().c_str(), history.data(), (int)history.size(), timer->GetHistoryOffset(),
+				overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+		}
+
+		if (ImGui::Button("Export trace"))
+		{
+			try
+			{
+				WriteChromeTrace("julia_trace.json", timers);
+			}
+			catch (const std::exception& err)
+			{
+				std::cerr << err.what() << std::endl;
+			}
+		}
+
 		// calculate mouse delta
 		double mouseX, mouseY;
 		glfwGetCursorPos(window->GetHandle(), &mouseX, &mouseY);
@@ -148,35 +269,79 @@ void Application::Launch()
 		data.lastMousePos.y = mouseY;
 
 		// Size of the domain (x direction)
-		float xSize = props.xBounds[1] - props.xBounds[0];
+		double xSize = props.xBounds[1] - props.xBounds[0];
 
 		// Camera panning handling
 		ImVec2 min = ImGui::GetWindowPos();
 		ImVec2 max = { min.x + ImGui::GetWindowWidth(), min.y + ImGui::GetWindowHeight() };
-		if (!ImGui::IsMouseHoveringRect(min, max) && glfwGetMouseButton(window->GetHandle(), GLFW_MOUSE_BUTTON_LEFT))
+		bool overCanvas = !ImGui::IsMouseHoveringRect(min, max);
+		if (canvas->GetShowAtlas())
 		{
-			float stepSize = xSize / (float)width;
-
-			props.xBounds[0] -= data.mouseDelta.x * stepSize;
-			props.xBounds[1] -= data.mouseDelta.x * stepSize;
-
-			props.yCenter += data.mouseDelta.y * stepSize;
+			// The atlas fills the window like the view, with y pointing up
+			if (overCanvas && ImGui::IsMouseClicked(0) &&
+				canvas->GetAtlasC((float)(mouseX / width), 1.0f - (float)(mouseY / height), props.c))
+			{
+				props.isPolar = false;
+				canvas->SetShowAtlas(false);
+			}
+		}
+		else if (overCanvas && glfwGetMouseButton(window->GetHandle(), GLFW_MOUSE_BUTTON_LEFT))
+		{
+			// Move in whole texture pixels, so the canvas can reuse the pixels that
+			// stay visible. Whatever is left over is applied in a later frame.
+			// The texture can be smaller than textureWidth while panning.
+			JuliaProperties rendered = props;
+			rendered.textureWidth = canvas->GetRenderWidth();
+			JuliaDomain domain = GetJuliaDomain(rendered);
+			double pixelWidth = xSize / domain.width;
+			double pixelHeight = (domain.yMax - domain.yMin) / domain.height;
+
+			data.panRemainder.x += data.mouseDelta.x * domain.width / (double)width;
+			data.panRemainder.y += data.mouseDelta.y * domain.height / (double)height;
+
+			double shiftX = std::trunc(data.panRemainder.x);
+			double shiftY = std::trunc(data.panRemainder.y);
+			data.panRemainder.x -= shiftX;
+			data.panRemainder.y -= shiftY;
+
+			props.xBounds[0] -= shiftX * pixelWidth;
+			props.xBounds[1] -= shiftX * pixelWidth;
+
+			props.yCenter += shiftY * pixelHeight;
+			lastInteraction = glfwGetTime();
+		}
+		else
+		{
+			data.panRemainder = { 0.0, 0.0 };
 		}
 
-		// Zooming
+		// Zooming by a constant factor per step, so zooming back out returns
+		// to the same view and finds its tiles in the cache
 		if (data.wheel.y != 0.0)
 		{
-			props.xBounds[0] += data.wheel.y * (xSize / 10.0f);
-			props.xBounds[1] -= data.wheel.y * (xSize / 10.0f);
+			double xCenter = 0.5 * (props.xBounds[0] + props.xBounds[1]);
+			double halfSize = 0.5 * xSize * std::pow(0.8, data.wheel.y);
+			props.xBounds[0] = xCenter - halfSize;
+			props.xBounds[1] = xCenter + halfSize;
+			lastInteraction = glfwGetTime();
 		}
 
 		data.wheel = { 0.0, 0.0 };
 
+		// Dragging a slider counts as well. Scrolling comes in single steps,
+		// so the interaction lasts a moment longer than the last input.
+		if (ImGui::IsAnyItemActive())
+			lastInteraction = glfwGetTime();
+
+		canvas->SetInteracting(glfwGetTime() - lastInteraction < 0.3);
+
 
 		ImGui::End();
 
 		ImGui::Render();
+		imguiTimer->Begin();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		imguiTimer->End();
 
 		window->Display();
 	}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include "Window.hpp"
 #include "Canvas.hpp"
 
@@ -8,7 +10,7 @@ struct WindowData
 	struct
 	{
 		double x, y;
-	} mouseDelta, lastMousePos, wheel;
+	} mouseDelta, lastMousePos, wheel, panRemainder;
 };
 
 class Application
@@ -22,6 +24,17 @@ public:
 private:
 	Window* window;
 	Canvas* canvas;
+	GpuTimer* imguiTimer;
 
 	WindowData data;
+
+	// Result of the last precision benchmark, in milliseconds
+	std::array<double, 3> precisionTimings;
+	bool hasPrecisionTimings;
+
+	// glfwGetTime() of the last pan, zoom or slider drag
+	double lastInteraction;
+
+	// Columns and rows of the c atlas
+	int atlasGrid;
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "Atlas.hpp"
+
+std::vector<std::array<float, 2>> MakeCGrid(uint32_t columns, uint32_t rows, double xMin, double xMax, double yMin, double yMax)
+{
+	std::vector<std::array<float, 2>> cValues;
+	cValues.reserve((size_t)columns * rows);
+
+	for (uint32_t row = 0; row < rows; row++)
+	{
+		for (uint32_t column = 0; column < columns; column++)
+		{
+			cValues.push_back({
+				(float)(xMin + (column + 0.5) * (xMax - xMin) / columns),
+				(float)(yMin + (row + 0.5) * (yMax - yMin) / rows)
+			});
+		}
+	}
+
+	return cValues;
+}
+
+AtlasRenderer::AtlasRenderer(uint32_t threadCount) :
+	scheduler(threadCount), instructionSet(DetectInstructionSet()), width(0), height(0)
+{
+}
+
+void AtlasRenderer::SetInstructionSet(InstructionSet isa)
+{
+	// Throws if the CPU doesn't support it
+	GetRowKernel(isa, false);
+
+	instructionSet = isa;
+}
+
+void AtlasRenderer::CalculateAtlas(const JuliaProperties& properties, const std::vector<std::array<float, 2>>& cValues, uint32_t columns)
+{
+	JuliaDomain view = GetJuliaDomain(properties);
+	uint32_t rows = columns > 0 ? (uint32_t)((cValues.size() + columns - 1) / columns) : 0;
+
+	width = columns * view.width;
+	height = rows * view.height;
+	iterations.assign((size_t)width * height, 0);
+	if (cValues.empty() || view.width == 0 || view.height == 0)
+		return;
+
+	// Everything but c and the escape radius is the same for every
+	// thumbnail. The regions keep the tiles from spanning two of them.
+	std::vector<JuliaDomain> domains;
+	std::vector<Tile> regions;
+	for (size_t i = 0; i < cValues.size(); i++)
+	{
+		JuliaProperties thumbnail = properties;
+		thumbnail.c[0] = cValues[i][0];
+		thumbnail.c[1] = cValues[i][1];
+		thumbnail.isPolar = false;
+		domains.push_back(GetJuliaDomain(thumbnail));
+
+		regions.push_back({ (uint32_t)(i % columns) * view.width, (uint32_t)(i / columns) * view.height, view.width, view.height });
+	}
+
+	RowKernel kernel = GetRowKernel(instructionSet, properties.precision != Precision::Single);
+	double dx = (view.xMax - view.xMin) / view.width;
+
+	scheduler.Run(regions, 64,
+		[&](const Tile& tile)
+		{
+			uint32_t column = tile.x / view.width;
+			uint32_t row = tile.y / view.height;
+			const JuliaDomain& domain = domains[(size_t)row * columns + column];
+
+			// Position of the tile within its thumbnail
+			uint32_t left = tile.x - column * view.width;
+			uint32_t bottom = tile.y - row * view.height;
+
+			KernelRow kernelRow = {};
+			kernelRow.x0 = domain.xMin + left * dx;
+			kernelRow.dx = dx;
+			kernelRow.c[0] = domain.c[0];
+			kernelRow.c[1] = domain.c[1];
+			kernelRow.threshold = domain.threshold;
+			kernelRow.periodicityTolerance = domain.periodicityTolerance;
+			kernelRow.maxIterations = properties.maxIterations;
+
+			for (uint32_t y = 0; y < tile.height; y++)
+			{
+				kernelRow.y = domain.yMin + (bottom + y) * (domain.yMax - domain.yMin) / view.height;
+				kernel(kernelRow, tile.width, &iterations[(size_t)(tile.y + y) * width + tile.x]);
+			}
+		}
+	);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "JuliaProperties.hpp"
+#include "SimdKernel.hpp"
+#include "TileScheduler.hpp"
+
+// c values on a grid over a rectangle of the c-plane, at the centers of
+// the cells. Index row * columns + column, rows go up from yMin.
+std::vector<std::array<float, 2>> MakeCGrid(uint32_t columns, uint32_t rows, double xMin, double xMax, double yMin, double yMax);
+
+// Calculates many Julia sets that share a view but have different c, as
+// thumbnails side by side in one image (an atlas). All thumbnails go into a
+// single run of the scheduler, so a few hundred small ones keep every
+// thread as busy as one large image does.
+class AtlasRenderer
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	AtlasRenderer(uint32_t threadCount = 0);
+
+	// Defaults to the widest instruction set the CPU supports
+	void SetInstructionSet(InstructionSet isa);
+
+	// The properties give the view and the size of a thumbnail, their c is
+	// replaced by the values of the list. Thumbnail i lands in column
+	// i % columns and row i / columns, counted from the bottom like the
+	// pixels. Cells without a c are left at 0.
+	void CalculateAtlas(const JuliaProperties& properties, const std::vector<std::array<float, 2>>& cValues, uint32_t columns);
+
+	// One count per pixel of the whole atlas, bottom row first, with
+	// InteriorIterations for points that never escape
+	inline const std::vector<uint32_t>& GetIterations() const { return iterations; }
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+	inline uint32_t GetThreadCount() const { return scheduler.GetThreadCount(); }
+
+private:
+	TileScheduler scheduler;
+	InstructionSet instructionSet;
+
+	uint32_t width, height;
+	std::vector<uint32_t> iterations;
+};
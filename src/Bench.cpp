@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "CpuRenderer.hpp"
+#include "EscapeTime.hpp"
+#include "MarianiSilver.hpp"
+#include "Perturbation.hpp"
+
+// Renders a fixed set of scenes through every engine and prints the results
+// as CSV, so runs on different commits or machines can be compared.
+
+struct Scene
+{
+	std::string name;
+	JuliaProperties properties;
+
+	// Deep zoom views can only be rendered by the perturbation engine
+	bool deep;
+	std::string center[2];
+	double viewWidth;
+};
+
+static JuliaProperties DefaultProperties()
+{
+	// Same as the interactive canvas starts with
+	JuliaProperties properties;
+	properties.xBounds[0] = -2.5;
+	properties.xBounds[1] = 2.5;
+	properties.yCenter = 0.0;
+	properties.aspectRatio = 9.0f / 16.0f;
+	properties.textureWidth = 1920;
+	properties.maxIterations = 100;
+	properties.iterationColorCutoff = 100.0f;
+	properties.palette = 0;
+	properties.c[0] = -0.835f;
+	properties.c[1] = -0.2321f;
+	properties.precision = Precision::Single;
+	properties.isPolar = false;
+	properties.periodicityCheck = false;
+
+	return properties;
+}
+
+static std::vector<Scene> GetScenes()
+{
+	std::vector<Scene> scenes;
+
+	Scene canvas = { "default", DefaultProperties(), false, { "", "" }, 0.0 };
+	scenes.push_back(canvas);
+
+	// The example from the README
+	Scene readme = canvas;
+	readme.name = "readme";
+	readme.properties.c[0] = 0.799f;
+	readme.properties.c[1] = 3.986f;
+	readme.properties.isPolar = true;
+	scenes.push_back(readme);
+
+	// Centered on the repelling fixed point of the default c, which lies on
+	// the Julia set at every zoom level
+	Scene deep = canvas;
+	deep.name = "deep";
+	deep.deep = true;
+	deep.center[0] = "1.5475083164876292121430003161843928605585597067411148983803285";
+	deep.center[1] = "0.1107867075439074733542442675553443916297902424057143994398092283";
+	deep.viewWidth = 1e-50;
+	scenes.push_back(deep);
+
+	return scenes;
+}
+
+struct EngineConfig
+{
+	std::string name;
+	std::unique_ptr<CpuEngine> engine;
+};
+
+static std::vector<EngineConfig> CreateEngines(uint32_t threadCount, bool deep, const Scene& scene)
+{
+	std::vector<EngineConfig> engines;
+
+	if (!deep)
+	{
+		for (InstructionSet isa : { InstructionSet::Scalar, InstructionSet::AVX2, InstructionSet::AVX512 })
+		{
+			if (!IsInstructionSetSupported(isa))
+				continue;
+
+			// Every frame has to be calculated from scratch
+			CpuRenderer* renderer = new CpuRenderer(threadCount);
+			renderer->SetInstructionSet(isa);
+			renderer->SetPanReuse(false);
+			renderer->SetResumeIterations(false);
+			engines.push_back({ std::string("escape-time-") + GetInstructionSetName(isa), std::unique_ptr<CpuEngine>(renderer) });
+		}
+
+		engines.push_back({ "mariani-silver", std::unique_ptr<CpuEngine>(new MarianiSilverRenderer(threadCount)) });
+	}
+
+	PerturbationRenderer* perturbation = new PerturbationRenderer(threadCount);
+	if (deep)
+		perturbation->SetView(scene.center[0], scene.center[1], scene.viewWidth);
+	engines.push_back({ "perturbation", std::unique_ptr<CpuEngine>(perturbation) });
+
+	return engines;
+}
+
+static double Percentile(std::vector<double> values, double fraction)
+{
+	std::sort(values.begin(), values.end());
+	size_t index = (size_t)(fraction * (values.size() - 1) + 0.5);
+	return values[std::min(index, values.size() - 1)];
+}
+
+static void PrintUsage()
+{
+	std::cerr <<
+		"Usage: julia_bench [options]\n"
+		"  --frames <n>           Frames per configuration (default 10)\n"
+		"  --threads <n>          Worker threads, 0 = all (default 0)\n"
+		"  --quick                Only the smallest resolution and iteration count\n"
+		"  --output <file>        Write the CSV to a file instead of stdout\n";
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = 10;
+	uint32_t threadCount = 0;
+	bool quick = false;
+	std::string outputPath;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+
+			// Returns the next argument, or throws if there isn't one
+			auto next = [&]() -> std::string
+			{
+				if (i + 1 >= argc)
+					throw std::runtime_error("Missing value for " + arg);
+
+				return argv[++i];
+			};
+
+			if (arg == "--frames")
+				frames = std::max(1ul, std::stoul(next()));
+			else if (arg == "--threads")
+				threadCount = std::stoul(next());
+			else if (arg == "--quick")
+				quick = true;
+			else if (arg == "--output")
+				outputPath = next();
+			else
+			{
+				PrintUsage();
+				throw std::runtime_error("Unknown option " + arg);
+			}
+		}
+
+		std::ofstream file;
+		if (!outputPath.empty())
+		{
+			file.open(outputPath);
+			if (!file)
+				throw std::runtime_error("Failed to open " + outputPath);
+		}
+		std::ostream& out = outputPath.empty() ? std::cout : file;
+
+		std::vector<uint32_t> widths = { 640, 1280, 1920 };
+		std::vector<uint32_t> iterationCounts = { 100, 500, 2000 };
+		if (quick)
+		{
+			widths = { 640 };
+			iterationCounts = { 100 };
+		}
+
+		out << std::fixed << std::setprecision(3);
+		out << "scene,engine,width,height,max_iterations,frames,mpixels_per_s,iterations_per_s,p50_ms,p99_ms" << std::endl;
+
+		for (const Scene& scene : GetScenes())
+		{
+			for (uint32_t width : widths)
+			{
+				for (uint32_t maxIterations : iterationCounts)
+				{
+					JuliaProperties properties = scene.properties;
+					properties.textureWidth = width;
+					properties.maxIterations = maxIterations;
+
+					for (EngineConfig& config : CreateEngines(threadCount, scene.deep, scene))
+					{
+						// One frame to warm up caches and the thread pool
+						config.engine->CalculateJuliaSet(properties);
+
+						std::vector<double> times;
+						for (uint32_t frame = 0; frame < frames; frame++)
+						{
+							auto start = std::chrono::steady_clock::now();
+							config.engine->CalculateJuliaSet(properties);
+							auto end = std::chrono::steady_clock::now();
+
+							times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+						}
+
+						// Iterations the image stands for, interior points count
+						// fully. Engines that skip work get credit for it.
+						uint64_t iterations = 0;
+						for (uint32_t count : config.engine->GetIterations())
+							iterations += (count == InteriorIterations) ? maxIterations : count;
+
+						uint64_t pixels = (uint64_t)config.engine->GetWidth() * config.engine->GetHeight();
+						double total = 0.0;
+						for (double time : times)
+							total += time;
+						double seconds = total / 1000.0 / frames;
+
+						out << scene.name << "," << config.name << ","
+							<< config.engine->GetWidth() << "," << config.engine->GetHeight() << ","
+							<< maxIterations << "," << frames << ","
+							<< pixels / seconds / 1e6 << "," << iterations / seconds << ","
+							<< Percentile(times, 0.5) << "," << Percentile(times, 0.99) << std::endl;
+					}
+				}
+			}
+		}
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "CachedEngine.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Rounds towards negative infinity, tile indices can be negative
+static int64_t FloorDivide(int64_t a, int64_t b)
+{
+	return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+// The wrapper runs nothing itself, a single worker keeps its own pool small
+CachedEngine::CachedEngine(CpuEngine& engine, TileCache& cache) :
+	CpuEngine(1), engine(engine), cache(cache), name(std::string("cached ") + engine.GetName()), cachedTiles(0), calculatedTiles(0)
+{
+	if (!engine.IsTileLocal())
+		throw std::runtime_error(std::string("The tile cache doesn't work with ") + engine.GetName() + " in this configuration");
+}
+
+void CachedEngine::CalculateJuliaSet(const JuliaProperties& properties)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+	cachedTiles = 0;
+	calculatedTiles = 0;
+
+	TileGrid grid;
+	// Settings of the engine are part of the key, tiles of another
+	// configuration are never reused
+	if (!GetTileGrid(properties, domain, engine.GetDescription(), grid))
+	{
+		engine.CalculateJuliaSet(properties);
+		width = engine.GetWidth();
+		height = engine.GetHeight();
+		iterations = engine.GetIterations();
+		return;
+	}
+
+	width = domain.width;
+	height = domain.height;
+	iterations.resize((size_t)width * height);
+
+	int64_t firstX = FloorDivide(grid.originX, CacheTileSize);
+	int64_t lastX = FloorDivide(grid.originX + width - 1, CacheTileSize);
+	int64_t firstY = FloorDivide(grid.originY, CacheTileSize);
+	int64_t lastY = FloorDivide(grid.originY + height - 1, CacheTileSize);
+
+	for (int64_t tileY = firstY; tileY <= lastY; tileY++)
+	{
+		for (int64_t tileX = firstX; tileX <= lastX; tileX++)
+		{
+			TileKey key = { grid.parameters, tileX, tileY };
+			if (cache.Find(key, tile))
+				cachedTiles++;
+			else
+			{
+				engine.CalculateJuliaSet(GetCacheTileProperties(properties, grid, tileX, tileY));
+				if (engine.GetWidth() != CacheTileSize || engine.GetHeight() != CacheTileSize)
+					throw std::runtime_error("Engine returned a tile of the wrong size");
+
+				tile = engine.GetIterations();
+				cache.Store(key, tile);
+				calculatedTiles++;
+			}
+
+			// Part of the tile that's inside the view, in view pixels
+			int64_t left = std::max<int64_t>(0, tileX * CacheTileSize - grid.originX);
+			int64_t right = std::min<int64_t>(width, (tileX + 1) * CacheTileSize - grid.originX);
+			int64_t bottom = std::max<int64_t>(0, tileY * CacheTileSize - grid.originY);
+			int64_t top = std::min<int64_t>(height, (tileY + 1) * CacheTileSize - grid.originY);
+
+			for (int64_t y = bottom; y < top; y++)
+			{
+				const uint32_t* source = &tile[(size_t)(grid.originY + y - tileY * CacheTileSize) * CacheTileSize + (size_t)(grid.originX + left - tileX * CacheTileSize)];
+				std::copy_n(source, (size_t)(right - left), &iterations[(size_t)y * width + (size_t)left]);
+			}
+		}
+	}
+}
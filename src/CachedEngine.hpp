@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include "CpuEngine.hpp"
+#include "TileCache.hpp"
+
+// Puts a TileCache in front of another engine. Views are split into the
+// tiles of the cache grid, only the tiles that aren't cached yet are passed
+// on to the engine, and they're calculated whole so they can be stored,
+// even where they stick out of the view.
+//
+// The engine has to be tile local, which rules out inverse iteration and a
+// PerturbationRenderer with its own view.
+class CachedEngine : public CpuEngine
+{
+public:
+	// Throws if the engine isn't tile local
+	CachedEngine(CpuEngine& engine, TileCache& cache);
+
+	void CalculateJuliaSet(const JuliaProperties& properties) override;
+	inline const char* GetName() const override { return name.c_str(); }
+
+	// The cache doesn't change the result
+	inline std::string GetDescription() const override { return engine.GetDescription(); }
+
+	// Tiles taken from the cache and calculated by the last call
+	inline uint32_t GetCachedTiles() const { return cachedTiles; }
+	inline uint32_t GetCalculatedTiles() const { return calculatedTiles; }
+
+private:
+	CpuEngine& engine;
+	TileCache& cache;
+	std::string name;
+
+	std::vector<uint32_t> tile;
+	uint32_t cachedTiles, calculatedTiles;
+};
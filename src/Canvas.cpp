@@ -3,17 +3,68 @@
 #include <string>
 #include <stdexcept>
 #include <complex>
-#include <regex>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
 
 #include <glad/glad.h>
 
+#include "EscapeTime.hpp"
+#include "Palette.hpp"
+#include "Tile.hpp"
+
 double Map(double fromMin, double fromMax, double toMin, double toMax, double val)
 {
 	return (val - fromMin) * (toMax - toMin) / (fromMax - fromMin) + toMin;
 }
 
+// Work group sizes found by TuneWorkGroupSize(), per GPU and driver
+static const char* WorkGroupCachePath = "workgroup_sizes.txt";
+
+// Binaries of the linked compute programs
+static const char* ProgramCachePath = "shader_cache.bin";
+
+// Select the precision of the escape time shader
+static const char* SingleDefines = "#define REAL float\n#define REAL2 vec2\n";
+static const char* DoubleDefines = "#define REAL double\n#define REAL2 dvec2\n";
+static const char* AtlasSingleDefines = "#define ATLAS\n#define REAL float\n#define REAL2 vec2\n";
+static const char* AtlasDoubleDefines = "#define ATLAS\n#define REAL double\n#define REAL2 dvec2\n";
+
+// Edge length of the dispatch slices, and how long one may take in
+// milliseconds. Drivers reset the GPU after about two seconds.
+static const uint32_t MinSliceSize = 64;
+static const uint32_t MaxSliceSize = 1024;
+static const double MaxSliceTime = 20.0;
+
+// Edge length of the region BenchmarkPrecisions() times at most
+static const uint32_t BenchmarkSize = 512;
+
+// Dynamic resolution never goes below this width
+static const uint32_t MinDynamicWidth = 160;
+
+// Tiles calculated in earlier sessions, 256 MiB at most
+static const char* TileCachePath = "tile_cache.bin";
+static const uint32_t TileCacheDiskSlots = 1024;
+
+// 64 MiB of the most recently used tiles stay in memory
+static const size_t TileCacheMemoryTiles = 256;
+
+// Splits a double into the high and low part of a double-float
+static void SplitDouble(double value, float& high, float& low)
+{
+	high = (float)value;
+	low = (float)(value - high);
+}
+
 Canvas::Canvas() :
-	vao(0), vbo(0), texture(0)
+	vao(0), vbo(0), workGroupSize{ 1, 1 }, computeTimer("Compute"), renderTimer("Render"), textures{ 0, 0, 0 }, currentTexture(0), displayedTexture(0), fenceTexture(0), showPartialView(false), textureSizes{}, statePixels(0), paletteTexture(0), uploadedPalette(0),
+	stateBuffer(0), stateValid(false), upToDate(false), panReuse(true), resumeIterations(true), symmetry(true), cacheTiles(true), readbackBuffer(0), readbackFence(nullptr),
+	dynamicResolution(true), interacting(false), targetFrameTime(16.0), pixelCost(0.0), costResultCount(0), dynamicWidth(0),
+	slicePrecision(Precision::Single), sliceDomain{}, sliceResume(false), resumeIteration(0), pendingMirror(false), mirrorOffset{ 0, 0 }, mirrorRegion{},
+	sliceFence(nullptr), atlasTexture(0), atlasBuffer(0), atlasColumns(0), atlasSize{ 0, 0 }, showAtlas(false)
 {
 	// Default Julia properties
 	properties.xBounds[0] = -2.5f;
@@ -23,22 +74,58 @@ Canvas::Canvas() :
 	properties.textureWidth = 1920;
 	properties.maxIterations = 100;
 	properties.iterationColorCutoff = 100.0f;
+	properties.palette = 0;
 	properties.c[0] = -0.835;
 	properties.c[1] = -0.2321;
-	properties.doublePrecision = false;
+	properties.precision = Precision::Single;
 	properties.isPolar = false;
+	properties.periodicityCheck = false;
+	calculatedProperties = properties;
+
+	// Without the file the cache still works within a session
+	try
+	{
+		tileCache.reset(new TileCache(TileCacheMemoryTiles, TileCachePath, TileCacheDiskSlots));
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << err.what() << std::endl;
+		tileCache.reset(new TileCache(TileCacheMemoryTiles));
+	}
 
 	CreateVertexArrayObject();
 	CreateShaderProgram();
 	CreateTexture();
+	CreatePaletteTexture();
 
 	CreateCompueShader();
 }
 
 Canvas::~Canvas()
 {
-	if (texture)
-		glDeleteTextures(1, &texture);
+	if (textures[0])
+		glDeleteTextures(TextureCount, textures);
+
+	if (paletteTexture)
+		glDeleteTextures(1, &paletteTexture);
+
+	if (stateBuffer)
+		glDeleteBuffers(1, &stateBuffer);
+
+	if (sliceFence)
+		glDeleteSync((GLsync)sliceFence);
+
+	if (readbackFence)
+		glDeleteSync((GLsync)readbackFence);
+
+	if (readbackBuffer)
+		glDeleteBuffers(1, &readbackBuffer);
+
+	if (atlasTexture)
+		glDeleteTextures(1, &atlasTexture);
+
+	if (atlasBuffer)
+		glDeleteBuffers(1, &atlasBuffer);
 
 	if (vbo)
 		glDeleteBuffers(1, &vbo);
@@ -49,74 +136,515 @@ Canvas::~Canvas()
 
 void Canvas::Render()
 {
-	// Wait for compute shader to finish
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	// Switch to the newest finished result. Drawing never waits for the
+	// compute shader, it shows the last texture the GPU completed.
+	PresentFinishedBatch();
+	StoreCachedTiles();
+
+	// Changing the palette only needs a new palette texture, the iteration
+	// counts stay the same
+	if (properties.palette != uploadedPalette)
+		UploadPalette(properties.palette);
 
 	// Render texture to screen
 	shader.Use();
-	glBindTexture(GL_TEXTURE_2D, texture);
+	glUniform1f(0, properties.iterationColorCutoff);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_1D, paletteTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, showAtlas && atlasTexture ? atlasTexture : textures[displayedTexture]);
 
+	renderTimer.Begin();
 	glBindVertexArray(vao);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	renderTimer.End();
 }
 
 void Canvas::CalculateJuliaSet()
 {
+	UpdateDispatchCost();
+
+	// While the user interacts, the view is calculated at whatever width
+	// fits into the frame time budget
+	JuliaProperties view = properties;
+	if (dynamicResolution && interacting)
+		view.textureWidth = GetDynamicWidth();
+
+	// Nothing new to do if the last view is still valid, but it may not be
+	// completely dispatched yet
+	if (upToDate && HaveSameIterations(view, calculatedProperties))
+	{
+		DispatchSlices();
+		return;
+	}
+
+	// Pixel reuse needs a finished texture, the rest of an unfinished one
+	// is dropped
+	if (!pendingSlices.empty() || pendingMirror)
+	{
+		pendingSlices.clear();
+		pendingMirror = false;
+		uncachedTiles.clear();
+		upToDate = false;
+
+		// The batch that's still running must not be shown when it's done
+		fenceTexture = displayedTexture;
+	}
+
 	// Wait for previous calculation to finish
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
 
-	// width and height of the target texture
-	int width = properties.textureWidth;
-	int height = properties.textureWidth * properties.aspectRatio;
+	// width, height and region of the complex plane of the target texture
+	JuliaDomain domain = GetJuliaDomain(view);
+	int width = domain.width;
+	int height = domain.height;
 
-	// domain in y direction
-	float yLength = (properties.xBounds[1] - properties.xBounds[0]) * properties.aspectRatio;
-	float yMin = properties.yCenter - 0.5f * yLength;
-	float yMax = properties.yCenter + 0.5f * yLength;
+	// Pixels can only be reused from a result of the same size
+	if (width != textureSizes[currentTexture][0] || height != textureSizes[currentTexture][1])
+		upToDate = false;
 
-	// Bind our texture object
-	glBindTexture(GL_TEXTURE_2D, texture);
+	// Continue iterating the pixels that haven't escaped yet, only dispatch
+	// what panning revealed, or dispatch everything
+	std::vector<Tile> regions;
+	int shiftX, shiftY;
+	bool resume = false;
+	if (resumeIterations && upToDate && stateValid && CanResumeIterations(calculatedProperties, view))
+	{
+		// The counts are updated in place, in a copy so the displayed
+		// texture stays untouched
+		ShiftTexture(0, 0);
+		regions.push_back({ 0, 0, (uint32_t)width, (uint32_t)height });
+		domain = calculatedDomain;
+		resume = true;
 
-	// Set texture properties (linear filtering)
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		// Every count is valid already, just not final
+		showPartialView = true;
+	}
+	else if (panReuse && upToDate && GetPixelShift(calculatedProperties, view, shiftX, shiftY))
+	{
+		ShiftTexture(shiftX, shiftY);
+		regions = GetExposedStrips(width, height, shiftX, shiftY);
 
-	// Re-create empty texture with right dimensions
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glGenerateMipmap(GL_TEXTURE_2D);
+		// Stay on the pixel grid of the reused pixels, otherwise rounding
+		// errors in the properties would show up as seams
+		domain = ShiftJuliaDomain(calculatedDomain, shiftX, shiftY);
 
-	// Prepare texture for use in the compute shader
-	glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+		// The stored z only covers the new strips now
+		stateValid = false;
 
-	// Decide whether to use single- or double precision shader
-	if (properties.doublePrecision)
-		doubleComputeShader.Use();
+		// The strips still hold an older result
+		showPartialView = false;
+	}
 	else
-		computeShader.Use();
+	{
+		regions.push_back({ 0, 0, (uint32_t)width, (uint32_t)height });
+		currentTexture = GetFreeTexture();
+		ResizeTexture(currentTexture, width, height);
+
+		// The free texture holds a result from two views ago, or nothing
+		// after a resize. Starting from the image on screen lets the first
+		// slices show up on top of it, otherwise the view is only shown once
+		// it's complete.
+		const int* displayedSize = textureSizes[displayedTexture];
+		showPartialView = displayedSize[0] == width && displayedSize[1] == height;
+		if (showPartialView)
+		{
+			glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+			glCopyImageSubData(
+				textures[displayedTexture], GL_TEXTURE_2D, 0, 0, 0, 0,
+				textures[currentTexture], GL_TEXTURE_2D, 0, 0, 0, 0,
+				width, height, 1
+			);
+		}
+
+		// Cached pixels come without their z. Reduced resolutions are
+		// short-lived, reading their tiles back would only stall.
+		bool reduced = view.textureWidth != properties.textureWidth;
+		stateValid = !(cacheTiles && !reduced && LoadCachedTiles(domain, regions));
+	}
+
+	// Leave out the pixels that can be copied from their mirror image. Panning
+	// only dispatches thin strips, those aren't worth it.
+	bool fullImage = regions.size() == 1 && regions[0].width == (uint32_t)width && regions[0].height == (uint32_t)height;
+	pendingMirror = symmetry && fullImage && GetMirrorSymmetry(domain, mirrorOffset[0], mirrorOffset[1], mirrorRegion);
 
-	// Set uniforms for shader
-	float c[2];
-	if (!properties.isPolar)
+	if (pendingMirror)
+		regions = SubtractTile(regions[0], mirrorRegion);
+
+	// Cut the work into slices that each stay well below the time a driver
+	// allows a single dispatch, and spread them over as many frames as needed
+	uint32_t sliceSize = GetSliceSize(view);
+	for (const Tile& region : regions)
+	{
+		for (const Tile& slice : SplitIntoTiles(region, sliceSize))
+			pendingSlices.push_back(slice);
+	}
+
+	slicePrecision = view.precision;
+	sliceDomain = domain;
+	sliceResume = resume;
+	resumeIteration = calculatedProperties.maxIterations;
+
+	calculatedProperties = view;
+	calculatedDomain = domain;
+	upToDate = true;
+
+	// Nothing to dispatch if every tile came from the cache, the uploads
+	// still have to finish before the texture is shown
+	if (pendingSlices.empty() && !pendingMirror)
+	{
+		if (sliceFence != nullptr)
+			glDeleteSync((GLsync)sliceFence);
+
+		sliceFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		fenceTexture = currentTexture;
+		return;
+	}
+
+	DispatchSlices();
+}
+
+void Canvas::DispatchSlices()
+{
+	if (pendingSlices.empty() && !pendingMirror)
+		return;
+
+	// Only queue more work once the GPU finished the last batch, otherwise
+	// slices pile up in the driver and the frames wait for them anyway
+	if (!PresentFinishedBatch())
+		return;
+
+	// As many slices as fit into the target time, but at least one
+	double pixelBudget = pixelCost > 0.0 ? targetFrameTime / (pixelCost * calculatedProperties.maxIterations) : 0.0;
+	size_t sliceCount = 0;
+	uint64_t pixels = 0;
+	while (sliceCount < pendingSlices.size())
+	{
+		uint64_t slicePixels = (uint64_t)pendingSlices[sliceCount].width * pendingSlices[sliceCount].height;
+		if (sliceCount > 0 && pixels + slicePixels > pixelBudget)
+			break;
+
+		pixels += slicePixels;
+		sliceCount++;
+	}
+
+	// Prepare texture for use in the compute shader. Resuming reads the
+	// counts back to skip the pixels that escaped already.
+	glBindImageTexture(0, textures[currentTexture], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, stateBuffer);
+
+	UseComputeShader(slicePrecision, sliceDomain, sliceResume);
+	computeTimer.Begin((double)pixels * calculatedProperties.maxIterations);
+
+	// Calculate Julia set
+	for (size_t i = 0; i < sliceCount; i++)
+	{
+		DispatchRegion(pendingSlices.front(), 5, 9);
+		pendingSlices.pop_front();
+	}
+
+	// Fill in the other half of the symmetric part
+	if (pendingSlices.empty() && pendingMirror)
+	{
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		mirrorShader->Use();
+		glUniform2i(1, mirrorOffset[0], mirrorOffset[1]);
+		DispatchRegion(mirrorRegion, 0, 2);
+		pendingMirror = false;
+	}
+
+	computeTimer.End();
+
+	// The texture is shown once the GPU is done with it. Views that take
+	// several batches show up batch by batch if that's possible.
+	sliceFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	bool complete = pendingSlices.empty() && !pendingMirror;
+	fenceTexture = complete || showPartialView ? currentTexture : displayedTexture;
+
+	if (pendingSlices.empty() && !uncachedTiles.empty())
+		ReadBackCachedTiles();
+}
+
+bool Canvas::PresentFinishedBatch()
+{
+	if (sliceFence == nullptr)
+		return true;
+
+	if (glClientWaitSync((GLsync)sliceFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		return false;
+
+	glDeleteSync((GLsync)sliceFence);
+	sliceFence = nullptr;
+
+	// The image stores are complete, this only makes them visible to the
+	// texture fetches of the draw and doesn't stall anything
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	displayedTexture = fenceTexture;
+	return true;
+}
+
+uint32_t Canvas::GetFreeTexture()
+{
+	// Neither the one on screen nor the last result, which may still be
+	// needed as the source of a copy
+	for (uint32_t i = 0; i < TextureCount; i++)
 	{
-		c[0] = properties.c[0];
-		c[1] = properties.c[1];
+		if (i != displayedTexture && i != currentTexture)
+			return i;
+	}
+
+	return currentTexture;
+}
+
+uint32_t Canvas::GetSliceSize(const JuliaProperties& view)
+{
+	// Before anything was measured, small enough for double precision at
+	// a few thousand iterations
+	if (pixelCost <= 0.0)
+		return MinSliceSize;
+
+	double pixels = MaxSliceTime / (pixelCost * view.maxIterations);
+	uint32_t size = (uint32_t)std::sqrt(pixels) / MinSliceSize * MinSliceSize;
+	return std::clamp(size, MinSliceSize, MaxSliceSize);
+}
+
+void Canvas::CalculateAtlas(const std::vector<std::array<float, 2>>& cValues, uint32_t columns, uint32_t thumbnailWidth)
+{
+	if (cValues.empty() || columns == 0)
+		return;
+
+	// The current view at the size of a thumbnail
+	JuliaProperties thumbnail = properties;
+	thumbnail.textureWidth = thumbnailWidth;
+	JuliaDomain domain = GetJuliaDomain(thumbnail);
+	uint32_t rows = (uint32_t)((cValues.size() + columns - 1) / columns);
+
+	atlasCValues = cValues;
+	atlasColumns = columns;
+	atlasSize[0] = columns * domain.width;
+	atlasSize[1] = rows * domain.height;
+
+	if (!atlasTexture)
+	{
+		glGenTextures(1, &atlasTexture);
+		glBindTexture(GL_TEXTURE_2D, atlasTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+		glGenBuffers(1, &atlasBuffer);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, atlasTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, atlasSize[0], atlasSize[1], 0, GL_RED, GL_FLOAT, nullptr);
+
+	// Cells of the last row without a thumbnail are never written
+	float interior = -1.0f;
+	glClearTexImage(atlasTexture, 0, GL_RED, GL_FLOAT, &interior);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, atlasBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(cValues.size() * sizeof(cValues[0])), cValues.data(), GL_STATIC_DRAW);
+
+	glBindImageTexture(0, atlasTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, stateBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, atlasBuffer);
+
+	// Double-float views use double precision for their thumbnails
+	if (properties.precision == Precision::Single)
+	{
+		computeAtlasShader->Use();
+		glUniform2f(1, (float)domain.xMin, (float)domain.xMax);
+		glUniform2f(2, (float)domain.yMin, (float)domain.yMax);
 	}
 	else
 	{
-		c[0] = properties.c[0] * cosf(properties.c[1]);
-		c[1] = properties.c[0] * sinf(properties.c[1]);
+		doubleAtlasShader->Use();
+		glUniform2d(1, domain.xMin, domain.xMax);
+		glUniform2d(2, domain.yMin, domain.yMax);
 	}
 
-	glUniform2f(1, properties.xBounds[0], properties.xBounds[1]);
-	glUniform2f(2, yMin, yMax);
-	glUniform2f(3, c[0], c[1]);
 	glUniform1i(4, properties.maxIterations);
-	glUniform1f(5, properties.iterationColorCutoff);
+	glUniform1i(6, false);
+	glUniform1i(7, 0);
+	glUniform1f(8, domain.periodicityTolerance);
+	glUniform2i(10, domain.width, domain.height);
+	glUniform1i(11, columns);
 
-	// Calculate Julia set
-	glDispatchCompute(width, height, 1);
+	// A row of thumbnails at a time, in slices like the view. The atlas is
+	// finished before this returns, so a glFinish() after each slice keeps
+	// every submission short enough for the driver's watchdog.
+	uint32_t sliceSize = GetSliceSize(properties);
+	computeTimer.Begin((double)atlasSize[0] * atlasSize[1] * properties.maxIterations);
+	for (uint32_t row = 0; row < rows; row++)
+	{
+		Tile thumbnailRow = { 0, row * domain.height, atlasSize[0], domain.height };
+		for (const Tile& slice : SplitIntoTiles(thumbnailRow, sliceSize))
+		{
+			DispatchRegion(slice, 5, 9);
+			glFinish();
+		}
+	}
+	computeTimer.End();
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+bool Canvas::GetAtlasC(float u, float v, float c[2])
+{
+	if (atlasCValues.empty() || atlasSize[0] == 0 || atlasSize[1] == 0 || u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f)
+		return false;
+
+	uint32_t rows = (uint32_t)((atlasCValues.size() + atlasColumns - 1) / atlasColumns);
+	size_t index = (size_t)(v * rows) * atlasColumns + (size_t)(u * atlasColumns);
+	if (index >= atlasCValues.size())
+		return false;
+
+	c[0] = atlasCValues[index][0];
+	c[1] = atlasCValues[index][1];
+	return true;
+}
+
+void Canvas::UpdateDispatchCost()
+{
+	if (computeTimer.GetResultCount() == costResultCount)
+		return;
+
+	costResultCount = computeTimer.GetResultCount();
+	if (computeTimer.GetLatestWork() <= 0.0)
+		return;
+
+	// Averaged over a few dispatches, single ones jump around with the
+	// part of the set that's in view. Cost is per pixel and per iteration of
+	// maxIterations, an upper bound that scales with the iteration count.
+	double cost = computeTimer.GetLatest() / computeTimer.GetLatestWork();
+	pixelCost = pixelCost > 0.0 ? 0.7 * pixelCost + 0.3 * cost : cost;
+}
+
+uint32_t Canvas::GetDynamicWidth()
+{
+	uint32_t fullWidth = std::max(properties.textureWidth, MinDynamicWidth);
+	if (pixelCost <= 0.0)
+		return dynamicWidth = fullWidth;
+
+	// Width of a full dispatch that takes the target time
+	double pixels = targetFrameTime / (pixelCost * properties.maxIterations);
+	double width = std::sqrt(pixels / std::max(properties.aspectRatio, 0.01f));
+	width = std::clamp(width, (double)MinDynamicWidth, (double)fullWidth);
+
+	// Only follow big changes, every new width throws away the pixels that
+	// panning could have reused
+	if (dynamicWidth == 0 || std::abs(width - dynamicWidth) > 0.15 * dynamicWidth)
+		dynamicWidth = std::min(fullWidth, (uint32_t)width / 32 * 32);
+
+	dynamicWidth = std::clamp(dynamicWidth, MinDynamicWidth, fullWidth);
+	return dynamicWidth;
+}
+
+std::array<double, 3> Canvas::BenchmarkPrecisions(uint32_t repetitions)
+{
+	std::array<double, 3> timings = { 0.0, 0.0, 0.0 };
+
+	JuliaDomain domain = GetJuliaDomain(properties);
+	int width = domain.width;
+	int height = domain.height;
+
+	// In a free texture, so the one on screen isn't touched
+	uint32_t target = GetFreeTexture();
+	ResizeTexture(target, width, height);
+
+	glBindImageTexture(0, textures[target], 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, stateBuffer);
+
+	// Only a region in the middle of the view is timed and the result scaled
+	// up to the whole view, a slow variant at a large view would stall the
+	// app for seconds otherwise
+	uint32_t regionWidth = std::min((uint32_t)width, BenchmarkSize);
+	uint32_t regionHeight = std::min((uint32_t)height, BenchmarkSize);
+	Tile region = { (width - regionWidth) / 2, (height - regionHeight) / 2, regionWidth, regionHeight };
+	double scale = (double)width * height / ((double)regionWidth * regionHeight);
+
+	// The variants are dispatched without any of the shortcuts, in slices
+	// with a glFinish() after each one, so no single submission runs long
+	// enough to freeze the display or trip the driver's watchdog. Each
+	// variant sizes its slices from a first dispatch of the smallest slice.
+	for (Precision precision : { Precision::Single, Precision::DoubleFloat, Precision::Double })
+	{
+		UseComputeShader(precision, domain, false);
+		glFinish();
+
+		Tile probe = { region.x, region.y, std::min(region.width, MinSliceSize), std::min(region.height, MinSliceSize) };
+		auto start = std::chrono::steady_clock::now();
+		DispatchRegion(probe, 5, 9);
+		glFinish();
+		double probeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		double pixels = MaxSliceTime / std::max(probeTime, 1e-3) * probe.width * probe.height;
+		uint32_t sliceSize = std::clamp((uint32_t)std::min(std::sqrt(pixels), (double)MaxSliceSize) / MinSliceSize * MinSliceSize,
+			MinSliceSize, MaxSliceSize);
+		std::vector<Tile> slices = SplitIntoTiles(region, sliceSize);
+
+		start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < repetitions; i++)
+		{
+			for (const Tile& slice : slices)
+			{
+				DispatchRegion(slice, 5, 9);
+				glFinish();
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		timings[(int)precision] = std::chrono::duration<double, std::milli>(end - start).count() / std::max(repetitions, 1u) * scale;
+	}
+
+	// The state buffer now holds whatever the last variant calculated
+	upToDate = false;
+	stateValid = false;
+
+	return timings;
+}
+
+void Canvas::UseComputeShader(Precision precision, const JuliaDomain& domain, bool resume)
+{
+	// The view is uploaded at the precision the shader calculates in
+	switch (precision)
+	{
+	case Precision::Single:
+		computeShader->Use();
+		glUniform2f(1, (float)domain.xMin, (float)domain.xMax);
+		glUniform2f(2, (float)domain.yMin, (float)domain.yMax);
+		break;
+
+	case Precision::DoubleFloat:
+	{
+		// Start and size of a pixel, as high and low floats
+		float x[4], y[4];
+		SplitDouble(domain.xMin, x[0], x[1]);
+		SplitDouble((domain.xMax - domain.xMin) / domain.width, x[2], x[3]);
+		SplitDouble(domain.yMin, y[0], y[1]);
+		SplitDouble((domain.yMax - domain.yMin) / domain.height, y[2], y[3]);
+
+		doubleFloatComputeShader->Use();
+		glUniform4fv(1, 1, x);
+		glUniform4fv(2, 1, y);
+		break;
+	}
+
+	case Precision::Double:
+		doubleComputeShader->Use();
+		glUniform2d(1, domain.xMin, domain.xMax);
+		glUniform2d(2, domain.yMin, domain.yMax);
+		break;
+	}
+
+	glUniform2f(3, domain.c[0], domain.c[1]);
+	glUniform1i(4, properties.maxIterations);
+	glUniform1i(6, resume);
+	glUniform1i(7, resumeIteration);
+	glUniform1f(8, domain.periodicityTolerance);
 }
 
 void Canvas::CreateVertexArrayObject()
@@ -169,11 +697,19 @@ void Canvas::CreateShaderProgram()
 		in vec2 uvCoord;
 		out vec4 FragColor;
 
-		uniform sampler2D canvas;
+		layout(binding = 0) uniform sampler2D canvas;
+		layout(binding = 1) uniform sampler1D palette;
+		layout(location = 0) uniform float iterationColorCutoff;
 
 		void main()
 		{
-			FragColor = texture(canvas, uvCoord);
+			// Iteration count, points inside the set are negative
+			float count = texture(canvas, uvCoord).x;
+			float t = clamp(count / iterationColorCutoff, 0.0f, 1.0f);
+
+			// Hit the centers of the first and last texel at t = 0 and t = 1
+			float size = float(textureSize(palette, 0));
+			FragColor = texture(palette, (0.5f + t * (size - 1.0f)) / size);
 		}
 	)";
 	shader.AttachFragmentShader(fragmentShaderSource);
@@ -185,69 +721,730 @@ void Canvas::CreateCompueShader()
 {
 	QueryWorkGroupInfo();
 
-	// Create compute shader
-	std::string shaderSource = R"(
-		#version 460 core
-
-		layout(local_size_x = 1, local_size_y = 1) in;
-		layout(rgba32f, binding = 0) uniform image2D img_out;
-		layout(location = 1) uniform vec2 xDomain;
-		layout(location = 2) uniform vec2 yDomain;
+	// Create compute shader. The version, the work group size and the
+	// precision are defined in front of the source when the variants are
+	// built.
+	escapeTimeSource = R"(
+		layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
+		layout(r32f, binding = 0) uniform image2D img_out;
+		layout(location = 1) uniform REAL2 xDomain;
+		layout(location = 2) uniform REAL2 yDomain;
+#ifndef ATLAS
 		layout(location = 3) uniform vec2 c;
+#endif
 		layout(location = 4) uniform int maxIterations;
-		layout(location = 5) uniform float iterationColorCutoff;
+		layout(location = 5) uniform ivec2 offset;
+		layout(location = 6) uniform bool resume;
+		layout(location = 7) uniform int firstIteration;
+		layout(location = 8) uniform float periodicityTolerance;
+		layout(location = 9) uniform ivec2 regionEnd;
+
+		// Last z of every pixel that didn't escape
+		layout(std430, binding = 1) buffer StateBuffer
+		{
+			REAL2 states[];
+		};
 
-		double map(double fromMin, double fromMax, double toMin, double toMax, double val)
+#ifdef ATLAS
+		// One thumbnail per c, in rows of atlasColumns
+		layout(location = 10) uniform ivec2 thumbnailSize;
+		layout(location = 11) uniform int atlasColumns;
+		layout(std430, binding = 2) readonly buffer CBuffer
+		{
+			vec2 cValues[];
+		};
+#endif
+
+		REAL map(REAL fromMin, REAL fromMax, REAL toMin, REAL toMax, REAL val)
 		{
 			return (val - fromMin) * (toMax - toMin) / (fromMax - fromMin) + toMin;
 		}
 
-		dvec2 complexMul(dvec2 a, dvec2 b)
+		REAL2 complexMul(REAL2 a, REAL2 b)
 		{
-			return dvec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+			return REAL2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
 		}
 
 		void main()
 		{
-			vec4 pixel = vec4(0.0f, 0.05f, 0.2f, 1.0f);
+			// Only the iteration count is stored, it is colored by the render
+			// shader. Points that never escape are marked with -1.
+			float count = -1.0f;
+
+			// Dispatches may only cover part of the image
+			ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy) + offset;
+			ivec2 image_size = imageSize(img_out);
 
-			ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
-			ivec2 image_size = ivec2(gl_NumWorkGroups.xy);
+			// The last work groups can reach past the end of the region
+			if (any(greaterThanEqual(pixel_coords, regionEnd)))
+				return;
 
-			double threshold = 0.5f * (sqrt(4 * length(c) + 1) + 1);
+			// Each thumbnail of an atlas maps the view onto its own pixels
+#ifdef ATLAS
+			ivec2 thumbnail = pixel_coords / thumbnailSize;
+			int cIndex = thumbnail.y * atlasColumns + thumbnail.x;
+			if (cIndex >= cValues.length())
+				return;
+
+			vec2 c = cValues[cIndex];
+			ivec2 view_coords = pixel_coords - thumbnail * thumbnailSize;
+			ivec2 view_size = thumbnailSize;
+#else
+			ivec2 view_coords = pixel_coords;
+			ivec2 view_size = imageSize(img_out);
+#endif
+
+			REAL threshold = 0.5f * (sqrt(4 * length(c) + 1) + 1);
+			int index = pixel_coords.y * image_size.x + pixel_coords.x;
 	
-			dvec2 z = dvec2(
-				map(0, image_size.x, xDomain.x, xDomain.y, pixel_coords.x),
-				map(0, image_size.y, yDomain.x, yDomain.y, pixel_coords.y)
+			REAL2 z = REAL2(
+				map(0, view_size.x, xDomain.x, xDomain.y, view_coords.x),
+				map(0, view_size.y, yDomain.x, yDomain.y, view_coords.y)
 			);
+
+			// Pick up where the last dispatch stopped, pixels that escaped
+			// already keep their count
+			int first = 0;
+			if (resume)
+			{
+				if (imageLoad(img_out, pixel_coords).x >= 0.0f)
+					return;
+
+				z = states[index];
+				first = firstIteration;
+			}
 	
-			for(int i = 0; i < maxIterations; i++)
+			// Brent's cycle detection: z is compared against a saved z, which
+			// is replaced after 1, 2, 4, 8, ... iterations
+			REAL2 saved = z;
+			int saveInterval = 1;
+			int sinceSave = 0;
+	
+			for(int i = first; i < maxIterations; i++)
 			{
 				if(length(z) > threshold)
 				{
-					pixel.x = float(i) / iterationColorCutoff;
+					count = float(i);
 					break;
 				}
 		
 				z = complexMul(z, z) + c;
+
+				// Points caught in an attracting cycle never escape
+				if (periodicityTolerance > 0.0f)
+				{
+					if (length(z - saved) < periodicityTolerance)
+						break;
+
+					if (++sinceSave == saveInterval)
+					{
+						saved = z;
+						sinceSave = 0;
+						saveInterval *= 2;
+					}
+				}
 			}
+
+#ifndef ATLAS
+			if (count < 0.0f)
+				states[index] = z;
+#endif
 	
-			imageStore(img_out, pixel_coords, pixel);
+			imageStore(img_out, pixel_coords, vec4(count, 0.0f, 0.0f, 0.0f));
 		}
 	)";
-	doubleComputeShader.AttachComputeShader(shaderSource);
-	doubleComputeShader.Link();
 
-	// Single precision shader is the exact same, except different datatypes
-	shaderSource = std::regex_replace(shaderSource, std::regex("double"), "float");
-	shaderSource = std::regex_replace(shaderSource, std::regex("dvec2"), "vec2");
-	computeShader.AttachComputeShader(shaderSource);
-	computeShader.Link();
+	// Emulated double precision. Every number is the unevaluated sum of two
+	// floats, which gives about 48 bits of mantissa at float throughput.
+	doubleFloatSource = R"(
+		layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
+		layout(r32f, binding = 0) uniform image2D img_out;
+
+		// Start and pixel size, high and low part of each
+		layout(location = 1) uniform vec4 xDomain;
+		layout(location = 2) uniform vec4 yDomain;
+		layout(location = 3) uniform vec2 c;
+		layout(location = 4) uniform int maxIterations;
+		layout(location = 5) uniform ivec2 offset;
+		layout(location = 6) uniform bool resume;
+		layout(location = 7) uniform int firstIteration;
+		layout(location = 8) uniform float periodicityTolerance;
+		layout(location = 9) uniform ivec2 regionEnd;
+
+		// Last z of every pixel that didn't escape, as (x, y)
+		layout(std430, binding = 1) buffer StateBuffer
+		{
+			vec4 states[];
+		};
+
+		// precise stops the compiler from simplifying the error terms away
+		vec2 twoSum(float a, float b)
+		{
+			precise float s = a + b;
+			precise float v = s - a;
+			precise float e = (a - (s - v)) + (b - v);
+			return vec2(s, e);
+		}
+
+		vec2 quickTwoSum(float a, float b)
+		{
+			precise float s = a + b;
+			precise float e = b - (s - a);
+			return vec2(s, e);
+		}
+
+		vec2 dfAdd(vec2 a, vec2 b)
+		{
+			precise vec2 s = twoSum(a.x, b.x);
+			precise vec2 t = twoSum(a.y, b.y);
+			s.y += t.x;
+			s = quickTwoSum(s.x, s.y);
+			s.y += t.y;
+			return quickTwoSum(s.x, s.y);
+		}
+
+		vec2 dfMul(vec2 a, vec2 b)
+		{
+			precise float p = a.x * b.x;
+			precise float e = fma(a.x, b.x, -p);
+			e += a.x * b.y + a.y * b.x;
+			return quickTwoSum(p, e);
+		}
+
+		void main()
+		{
+			float count = -1.0f;
+
+			ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy) + offset;
+			ivec2 image_size = imageSize(img_out);
+
+			// The last work groups can reach past the end of the region
+			if (any(greaterThanEqual(pixel_coords, regionEnd)))
+				return;
+
+			float threshold = 0.5f * (sqrt(4 * length(c) + 1) + 1);
+			int index = pixel_coords.y * image_size.x + pixel_coords.x;
+
+			vec2 zx = dfAdd(xDomain.xy, dfMul(vec2(pixel_coords.x, 0.0f), xDomain.zw));
+			vec2 zy = dfAdd(yDomain.xy, dfMul(vec2(pixel_coords.y, 0.0f), yDomain.zw));
+
+			int first = 0;
+			if (resume)
+			{
+				if (imageLoad(img_out, pixel_coords).x >= 0.0f)
+					return;
+
+				zx = states[index].xy;
+				zy = states[index].zw;
+				first = firstIteration;
+			}
+
+			vec2 savedX = zx, savedY = zy;
+			int saveInterval = 1;
+			int sinceSave = 0;
+
+			for(int i = first; i < maxIterations; i++)
+			{
+				// The high parts are plenty for the escape test
+				if(length(vec2(zx.x, zy.x)) > threshold)
+				{
+					count = float(i);
+					break;
+				}
+
+				vec2 xy = dfMul(zx, zy);
+				zx = dfAdd(dfAdd(dfMul(zx, zx), -dfMul(zy, zy)), vec2(c.x, 0.0f));
+				zy = dfAdd(2.0f * xy, vec2(c.y, 0.0f));
+
+				if (periodicityTolerance > 0.0f)
+				{
+					vec2 dx = dfAdd(zx, -savedX);
+					vec2 dy = dfAdd(zy, -savedY);
+					if (length(vec2(dx.x, dy.x)) < periodicityTolerance)
+						break;
+
+					if (++sinceSave == saveInterval)
+					{
+						savedX = zx;
+						savedY = zy;
+						sinceSave = 0;
+						saveInterval *= 2;
+					}
+				}
+			}
+
+			if (count < 0.0f)
+				states[index] = vec4(zx, zy);
+
+			imageStore(img_out, pixel_coords, vec4(count, 0.0f, 0.0f, 0.0f));
+		}
+	)";
+
+	// Copies iteration counts from the mirror image of each pixel
+	mirrorSource = R"(
+		layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
+		layout(r32f, binding = 0) uniform image2D img_out;
+		layout(location = 0) uniform ivec2 offset;
+		layout(location = 1) uniform ivec2 mirror;
+		layout(location = 2) uniform ivec2 regionEnd;
+
+		void main()
+		{
+			ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy) + offset;
+			if (any(greaterThanEqual(pixel_coords, regionEnd)))
+				return;
+
+			imageStore(img_out, pixel_coords, imageLoad(img_out, mirror - pixel_coords));
+		}
+	)";
+
+	// Starting with the programs of the last run makes the start a single
+	// file read
+	programCache = std::make_unique<ProgramCache>(ProgramCachePath, GetDeviceName());
+
+	// Use the work group size found for this GPU before, or find one now
+	if (!LoadWorkGroupSize())
+		TuneWorkGroupSize();
+	else
+		BuildComputeShaders();
 }
 
-void Canvas::CreateTexture()
+// One variant of a compute shader source, with the given work group size
+// and the defines of its precision
+static std::string MakeVariant(const std::string& source, int sizeX, int sizeY, const char* defines = "")
+{
+	return
+		"#version 460 core\n"
+		"#define LOCAL_SIZE_X " + std::to_string(sizeX) + "\n"
+		"#define LOCAL_SIZE_Y " + std::to_string(sizeY) + "\n" +
+		defines + source;
+}
+
+static std::unique_ptr<Shader> CreateComputeProgram(const std::string& source)
+{
+	std::unique_ptr<Shader> program = std::make_unique<Shader>();
+	program->AttachComputeShader(source);
+	program->Link();
+
+	return program;
+}
+
+void Canvas::BuildComputeShaders()
+{
+	int sizeX = workGroupSize[0];
+	int sizeY = workGroupSize[1];
+
+	// Single and double precision are the same source with different types
+	doubleComputeShader = programCache->CreateComputeProgram(MakeVariant(escapeTimeSource, sizeX, sizeY, DoubleDefines));
+	computeShader = programCache->CreateComputeProgram(MakeVariant(escapeTimeSource, sizeX, sizeY, SingleDefines));
+
+	// Thumbnails of many c at once, there's no double-float variant
+	computeAtlasShader = programCache->CreateComputeProgram(MakeVariant(escapeTimeSource, sizeX, sizeY, AtlasSingleDefines));
+	doubleAtlasShader = programCache->CreateComputeProgram(MakeVariant(escapeTimeSource, sizeX, sizeY, AtlasDoubleDefines));
+
+	doubleFloatComputeShader = programCache->CreateComputeProgram(MakeVariant(doubleFloatSource, sizeX, sizeY));
+	mirrorShader = programCache->CreateComputeProgram(MakeVariant(mirrorSource, sizeX, sizeY));
+
+	programCache->Save();
+}
+
+void Canvas::DispatchRegion(const Tile& region, int offsetLocation, int endLocation)
+{
+	glUniform2i(offsetLocation, region.x, region.y);
+	glUniform2i(endLocation, region.x + region.width, region.y + region.height);
+	glDispatchCompute(
+		(region.width + workGroupSize[0] - 1) / workGroupSize[0],
+		(region.height + workGroupSize[1] - 1) / workGroupSize[1],
+		1
+	);
+}
+
+std::string Canvas::GetDeviceName()
+{
+	return
+		std::string((const char*)glGetString(GL_VENDOR)) + " / " +
+		std::string((const char*)glGetString(GL_RENDERER)) + " / " +
+		std::string((const char*)glGetString(GL_VERSION));
+}
+
+bool Canvas::LoadWorkGroupSize()
+{
+	// One line per GPU and driver: "<x> <y> <device name>"
+	std::ifstream file(WorkGroupCachePath);
+	std::string device = GetDeviceName();
+
+	int sizeX, sizeY;
+	std::string name;
+	while (file >> sizeX >> sizeY && std::getline(file >> std::ws, name))
+	{
+		if (name != device)
+			continue;
+
+		// Don't trust a cache that was edited by hand or made for other limits
+		if (sizeX < 1 || sizeY < 1 || sizeX > workProperties.groupSize[0] || sizeY > workProperties.groupSize[1] ||
+			sizeX * sizeY > workProperties.maxInvocations)
+		{
+			return false;
+		}
+
+		workGroupSize[0] = sizeX;
+		workGroupSize[1] = sizeY;
+		return true;
+	}
+
+	return false;
+}
+
+void Canvas::SaveWorkGroupSize()
+{
+	// Keep the entries of the other devices
+	std::vector<std::string> lines;
+	std::string device = GetDeviceName();
+	{
+		std::ifstream file(WorkGroupCachePath);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream entry(line);
+			int sizeX, sizeY;
+			std::string name;
+			if (entry >> sizeX >> sizeY && std::getline(entry >> std::ws, name) && name != device)
+				lines.push_back(line);
+		}
+	}
+
+	lines.push_back(std::to_string(workGroupSize[0]) + " " + std::to_string(workGroupSize[1]) + " " + device);
+
+	// Not being able to write the cache only means tuning again next time
+	std::ofstream file(WorkGroupCachePath, std::ios::trunc);
+	for (const std::string& line : lines)
+		file << line << "\n";
+}
+
+void Canvas::TuneWorkGroupSize()
 {
+	// Candidates from a single invocation up to 1024, as squares up to 32x32
+	// and rows 32 or 64 wide. Powers of two line up with the subgroup sizes
+	// of common GPUs (32 or 64).
+	const int candidates[][2] = {
+		{ 1, 1 }, { 8, 1 }, { 8, 4 }, { 8, 8 }, { 16, 4 }, { 16, 8 }, { 16, 16 },
+		{ 32, 1 }, { 32, 2 }, { 32, 4 }, { 32, 8 }, { 32, 16 }, { 32, 32 }, { 64, 1 }, { 64, 4 }
+	};
+
+	// Time them on the default view, in a texture of their own so the
+	// canvas isn't disturbed
+	JuliaProperties benchmark = properties;
+	benchmark.xBounds[0] = -2.5;
+	benchmark.xBounds[1] = 2.5;
+	benchmark.yCenter = 0.0;
+	benchmark.aspectRatio = 9.0f / 16.0f;
+	benchmark.textureWidth = 1024;
+	benchmark.maxIterations = 256;
+	benchmark.c[0] = -0.835f;
+	benchmark.c[1] = -0.2321f;
+	benchmark.isPolar = false;
+	benchmark.periodicityCheck = false;
+	JuliaDomain domain = GetJuliaDomain(benchmark);
+
+	uint32_t texture, buffer;
 	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, domain.width, domain.height, 0, GL_RED, GL_FLOAT, nullptr);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)domain.width * domain.height * 2 * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+
+	glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffer);
+
+	double bestTime = 0.0;
+	int best[2] = { 1, 1 };
+	for (const int* candidate : candidates)
+	{
+		if (candidate[0] > workProperties.groupSize[0] || candidate[1] > workProperties.groupSize[1] ||
+			candidate[0] * candidate[1] > workProperties.maxInvocations)
+		{
+			continue;
+		}
+
+		workGroupSize[0] = candidate[0];
+		workGroupSize[1] = candidate[1];
+
+		std::unique_ptr<Shader> program = CreateComputeProgram(MakeVariant(escapeTimeSource, candidate[0], candidate[1], SingleDefines));
+		program->Use();
+		glUniform2f(1, (float)domain.xMin, (float)domain.xMax);
+		glUniform2f(2, (float)domain.yMin, (float)domain.yMax);
+		glUniform2f(3, domain.c[0], domain.c[1]);
+		glUniform1i(4, benchmark.maxIterations);
+		glUniform1i(6, false);
+		glUniform1i(7, 0);
+		glUniform1f(8, 0.0f);
+
+		// One dispatch to warm up, then the fastest of a few
+		Tile region = { 0, 0, domain.width, domain.height };
+		DispatchRegion(region, 5, 9);
+		glFinish();
+
+		double time = 0.0;
+		for (int i = 0; i < 3; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			DispatchRegion(region, 5, 9);
+			glFinish();
+			auto end = std::chrono::steady_clock::now();
+
+			double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+			time = (i == 0) ? elapsed : std::min(time, elapsed);
+		}
+
+		if (bestTime == 0.0 || time < bestTime)
+		{
+			bestTime = time;
+			best[0] = candidate[0];
+			best[1] = candidate[1];
+		}
+	}
+
+	glDeleteTextures(1, &texture);
+	glDeleteBuffers(1, &buffer);
+
+	workGroupSize[0] = best[0];
+	workGroupSize[1] = best[1];
+	SaveWorkGroupSize();
+
+	BuildComputeShaders();
+
+	// The canvas texture and buffer were unbound for the benchmark
+	upToDate = false;
+	stateValid = false;
+}
+
+void Canvas::CreateTexture()
+{
+	glGenTextures(TextureCount, textures);
+	glGenBuffers(1, &stateBuffer);
+
+	for (uint32_t texture : textures)
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+
+		// Set texture properties (linear filtering)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	}
+}
+
+bool Canvas::LoadCachedTiles(const JuliaDomain& domain, std::vector<Tile>& regions)
+{
+	uncachedTiles.clear();
+	if (!GetTileGrid(properties, domain, "gpu", cacheGrid))
+		return false;
+
+	int64_t width = domain.width;
+	int64_t height = domain.height;
+	int64_t tileSize = CacheTileSize;
+
+	// Tile indices of the first and last pixel, rounded towards negative
+	// infinity
+	auto tileIndex = [&](int64_t pixel) { return (pixel >= 0 ? pixel : pixel - tileSize + 1) / tileSize; };
+
+	glBindTexture(GL_TEXTURE_2D, textures[currentTexture]);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, CacheTileSize);
+
+	std::vector<Tile> missing;
+	bool found = false;
+	for (int64_t tileY = tileIndex(cacheGrid.originY); tileY <= tileIndex(cacheGrid.originY + height - 1); tileY++)
+	{
+		for (int64_t tileX = tileIndex(cacheGrid.originX); tileX <= tileIndex(cacheGrid.originX + width - 1); tileX++)
+		{
+			// Part of the tile that's inside the texture
+			int64_t left = std::max<int64_t>(0, tileX * tileSize - cacheGrid.originX);
+			int64_t right = std::min<int64_t>(width, (tileX + 1) * tileSize - cacheGrid.originX);
+			int64_t bottom = std::max<int64_t>(0, tileY * tileSize - cacheGrid.originY);
+			int64_t top = std::min<int64_t>(height, (tileY + 1) * tileSize - cacheGrid.originY);
+			Tile region = { (uint32_t)left, (uint32_t)bottom, (uint32_t)(right - left), (uint32_t)(top - bottom) };
+
+			TileKey key = { cacheGrid.parameters, tileX, tileY };
+			if (!tileCache->Find(key, cachedIterations))
+			{
+				missing.push_back(region);
+
+				// Tiles cut off by the edges can't be stored
+				if (region.width == CacheTileSize && region.height == CacheTileSize)
+					uncachedTiles.push_back({ key, region });
+
+				continue;
+			}
+
+			// The shaders mark the interior with -1
+			cachedCounts.resize(cachedIterations.size());
+			for (size_t i = 0; i < cachedIterations.size(); i++)
+				cachedCounts[i] = cachedIterations[i] == InteriorIterations ? -1.0f : (float)cachedIterations[i];
+
+			glPixelStorei(GL_UNPACK_SKIP_PIXELS, (GLint)(cacheGrid.originX + left - tileX * tileSize));
+			glPixelStorei(GL_UNPACK_SKIP_ROWS, (GLint)(cacheGrid.originY + bottom - tileY * tileSize));
+			glTexSubImage2D(GL_TEXTURE_2D, 0, region.x, region.y, region.width, region.height, GL_RED, GL_FLOAT, cachedCounts.data());
+			found = true;
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+	// A view that has nothing cached stays a single region, so it can still
+	// use the symmetry
+	if (found)
+		regions = missing;
+
+	return found;
+}
+
+void Canvas::ReadBackCachedTiles()
+{
+	// Only one readback at a time. Waiting for the last one would stall the
+	// frame, so the new tiles just don't get stored.
+	StoreCachedTiles();
+	if (readbackFence != nullptr)
+	{
+		uncachedTiles.clear();
+		return;
+	}
+
+	// The copies into the buffer are queued behind the dispatches that
+	// write the tiles, nothing waits for them here
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	GLsizeiptr tileBytes = (GLsizeiptr)CacheTileSize * CacheTileSize * sizeof(float);
+	if (!readbackBuffer)
+		glGenBuffers(1, &readbackBuffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, tileBytes * (GLsizeiptr)uncachedTiles.size(), nullptr, GL_STREAM_READ);
+
+	for (size_t i = 0; i < uncachedTiles.size(); i++)
+	{
+		const Tile& region = uncachedTiles[i].second;
+		glGetTextureSubImage(textures[currentTexture], 0, region.x, region.y, 0, region.width, region.height, 1,
+			GL_RED, GL_FLOAT, (GLsizei)tileBytes, (void*)(tileBytes * i));
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackTiles.swap(uncachedTiles);
+	uncachedTiles.clear();
+}
+
+void Canvas::StoreCachedTiles()
+{
+	if (readbackFence == nullptr || glClientWaitSync((GLsync)readbackFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		return;
+
+	glDeleteSync((GLsync)readbackFence);
+	readbackFence = nullptr;
+
+	size_t tilePixels = (size_t)CacheTileSize * CacheTileSize;
+	GLsizeiptr size = (GLsizeiptr)(readbackTiles.size() * tilePixels * sizeof(float));
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer);
+	const float* counts = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (counts != nullptr)
+	{
+		cachedIterations.resize(tilePixels);
+		for (size_t tile = 0; tile < readbackTiles.size(); tile++)
+		{
+			const float* tileCounts = counts + tile * tilePixels;
+			for (size_t i = 0; i < tilePixels; i++)
+				cachedIterations[i] = tileCounts[i] < 0.0f ? InteriorIterations : (uint32_t)tileCounts[i];
+
+			tileCache->Store(readbackTiles[tile].first, cachedIterations);
+		}
+
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readbackTiles.clear();
+}
+
+void Canvas::ResizeTexture(uint32_t index, int width, int height)
+{
+	// Re-create empty texture with right dimensions. The texture is never
+	// sampled with a mipmap filter, so no mipmaps are needed.
+	// It only holds the iteration count, R32F (unlike an integer format)
+	// can still be filtered linearly when it's drawn.
+	if (width != textureSizes[index][0] || height != textureSizes[index][1])
+	{
+		glBindTexture(GL_TEXTURE_2D, textures[index]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+
+		textureSizes[index][0] = width;
+		textureSizes[index][1] = height;
+	}
+
+	// Room for one dvec2 (or two double-floats) per pixel, the single
+	// precision shader only uses half
+	size_t pixels = (size_t)width * height;
+	if (pixels != statePixels)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, stateBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)pixels * 2 * sizeof(double), nullptr, GL_DYNAMIC_COPY);
+
+		statePixels = pixels;
+		stateValid = false;
+	}
+}
+
+void Canvas::ShiftTexture(int shiftX, int shiftY)
+{
+	// Wait for the compute shader before copying what it wrote
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	// Pixel (x, y) of the new view is pixel (x + shiftX, y + shiftY) of the
+	// old one. Copying within one texture is undefined if the regions
+	// overlap, and the old one may be on screen, so copy into a free one.
+	int width = textureSizes[currentTexture][0];
+	int height = textureSizes[currentTexture][1];
+	uint32_t targetIndex = GetFreeTexture();
+	ResizeTexture(targetIndex, width, height);
+
+	glCopyImageSubData(
+		textures[currentTexture], GL_TEXTURE_2D, 0, std::max(shiftX, 0), std::max(shiftY, 0), 0,
+		textures[targetIndex], GL_TEXTURE_2D, 0, std::max(-shiftX, 0), std::max(-shiftY, 0), 0,
+		width - std::abs(shiftX), height - std::abs(shiftY), 1
+	);
+
+	currentTexture = targetIndex;
+}
+
+void Canvas::CreatePaletteTexture()
+{
+	glGenTextures(1, &paletteTexture);
+	glBindTexture(GL_TEXTURE_1D, paletteTexture);
+
+	// The render shader relies on linear filtering to blend between colors
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+	UploadPalette(properties.palette);
+}
+
+void Canvas::UploadPalette(uint32_t index)
+{
+	const std::vector<Palette>& palettes = GetPalettes();
+	if (index >= palettes.size())
+		index = 0;
+
+	const Palette& palette = palettes[index];
+
+	glBindTexture(GL_TEXTURE_1D, paletteTexture);
+	glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB32F, palette.GetSize(), 0, GL_RGB, GL_FLOAT, palette.colors.data());
+
+	uploadedPalette = index;
 }
 
 void Canvas::QueryWorkGroupInfo()
@@ -1,20 +1,18 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include "Shader.hpp"
-
-struct JuliaProperties
-{
-	float xBounds[2];
-	float yCenter;
-	float aspectRatio;
-	uint32_t maxIterations;
-	float iterationColorCutoff;
-	uint32_t textureWidth;
-	float c[2];
-	bool doublePrecision;
-	bool isPolar;
-};
+#include "ProgramCache.hpp"
+#include "GpuTimer.hpp"
+#include "JuliaProperties.hpp"
+#include "Tile.hpp"
+#include "TileCache.hpp"
 
 struct WorkProperties
 {
@@ -30,7 +28,81 @@ public:
 	~Canvas();
 
 	void Render();
+
+	// Dispatches the compute shader, but only if the properties changed
+	// since the last dispatch
 	void CalculateJuliaSet();
+
+	// Forces the next call to CalculateJuliaSet() to dispatch
+	inline void Invalidate() { upToDate = false; }
+
+	// If the view only moved by whole pixels, keep the pixels that are
+	// still visible and only dispatch the newly exposed edges
+	inline void SetPanReuse(bool enabled) { panReuse = enabled; }
+	inline bool GetPanReuse() { return panReuse; }
+
+	// When only maxIterations went up, continue iterating the pixels that
+	// didn't escape yet from their stored z instead of starting over
+	inline void SetResumeIterations(bool enabled) { resumeIterations = enabled; stateValid = false; }
+	inline bool GetResumeIterations() { return resumeIterations; }
+
+	// If the image overlaps its own mirror image under z -> -z, only
+	// calculate one half of the overlap and copy the other. Mirrored pixels
+	// get no stored z, so the next view can't resume.
+	inline void SetSymmetry(bool enabled) { symmetry = enabled; stateValid = false; }
+	inline bool GetSymmetry() { return symmetry; }
+
+	// Look up the tiles of a new view in the tile cache before dispatching,
+	// and store the ones that were calculated
+	inline void SetTileCache(bool enabled) { cacheTiles = enabled; }
+	inline bool GetTileCache() { return cacheTiles; }
+	inline TileCacheStats GetTileCacheStats() { return tileCache->GetStats(); }
+
+	// Lowers the resolution while the user pans or zooms, far enough to
+	// keep the compute dispatches within the target frame time, and goes
+	// back to the full textureWidth once the interaction stopped
+	inline void SetDynamicResolution(bool enabled) { dynamicResolution = enabled; }
+	inline bool GetDynamicResolution() { return dynamicResolution; }
+	inline void SetInteracting(bool active) { interacting = active; }
+	inline void SetTargetFrameTime(float milliseconds) { targetFrameTime = milliseconds; }
+	inline float GetTargetFrameTime() { return targetFrameTime; }
+
+	// Slices of the current view that still have to be dispatched, views
+	// that take longer than a frame are finished over several frames
+	inline size_t GetPendingSlices() { return pendingSlices.size(); }
+
+	// Width of the texture that was calculated last
+	inline uint32_t GetRenderWidth() { return calculatedProperties.textureWidth; }
+
+	// Calculates the current view once per c, as thumbnails of the given
+	// width side by side in a texture of their own, dispatched in slices.
+	// Thumbnail i goes to column i % columns and row i / columns, counted
+	// from the bottom.
+	void CalculateAtlas(const std::vector<std::array<float, 2>>& cValues, uint32_t columns, uint32_t thumbnailWidth);
+
+	// Draw the atlas instead of the view
+	inline void SetShowAtlas(bool show) { showAtlas = show; }
+	inline bool GetShowAtlas() { return showAtlas; }
+
+	// c of the thumbnail at a point of the atlas, both coordinates from 0 to
+	// 1 with y pointing up. False if there's no thumbnail.
+	bool GetAtlasC(float u, float v, float c[2]);
+
+	// Estimates the time of one full dispatch of every shader variant at the
+	// current view, from a region of at most 512x512 pixels dispatched in
+	// slices and averaged over a number of repetitions. In milliseconds,
+	// indexed by Precision.
+	std::array<double, 3> BenchmarkPrecisions(uint32_t repetitions);
+
+	// Times compute shaders with a range of work group sizes, keeps the
+	// fastest and remembers it for this GPU and driver
+	void TuneWorkGroupSize();
+	inline const int* GetWorkGroupSize() { return workGroupSize; }
+
+	// GPU time of the compute dispatches and of drawing the texture
+	inline GpuTimer& GetComputeTimer() { return computeTimer; }
+	inline GpuTimer& GetRenderTimer() { return renderTimer; }
+
 	inline JuliaProperties& GetProperties() { return properties; }
 	inline const WorkProperties& GetWorkProperties() { return workProperties; }
 
@@ -39,14 +111,155 @@ private:
 	void CreateShaderProgram();
 	void CreateCompueShader();
 	void CreateTexture();
+	// Re-creates one texture if its size differs, along with the state
+	// buffer if that doesn't fit the size either
+	void ResizeTexture(uint32_t index, int width, int height);
+	// Copies the current texture into a free one, moved by the given
+	// number of pixels, and makes that the current one
+	void ShiftTexture(int shiftX, int shiftY);
+	void CreatePaletteTexture();
+	void UploadPalette(uint32_t index);
 
 	void QueryWorkGroupInfo();
 
+	// (Re-)creates the compute shaders with the current work group size
+	void BuildComputeShaders();
+
+	// Dispatches enough work groups to cover the region. The locations are
+	// those of the offset and region end uniforms of the bound shader.
+	void DispatchRegion(const Tile& region, int offsetLocation, int endLocation);
+
+	static std::string GetDeviceName();
+	bool LoadWorkGroupSize();
+	void SaveWorkGroupSize();
+
+	// Binds the compute shader of a precision and sets its uniforms
+	void UseComputeShader(Precision precision, const JuliaDomain& domain, bool resume);
+
+	// Uploads the cached tiles of the view and replaces regions with what's
+	// left to dispatch. Returns false if nothing was found.
+	bool LoadCachedTiles(const JuliaDomain& domain, std::vector<Tile>& regions);
+
+	// Starts reading the tiles that were dispatched back into a pixel pack
+	// buffer, without waiting for the dispatches
+	void ReadBackCachedTiles();
+
+	// Stores the tiles of the last readback once the GPU finished it
+	void StoreCachedTiles();
+
+	// Dispatches as many pending slices as fit into the target frame time
+	void DispatchSlices();
+
+	// If the last batch of slices finished, shows its texture and returns
+	// true. Also true if there's no batch.
+	bool PresentFinishedBatch();
+
+	// A texture that's neither displayed nor holds the last result
+	uint32_t GetFreeTexture();
+
+	// Edge length of slices that stay below MaxSliceTime at this view
+	uint32_t GetSliceSize(const JuliaProperties& view);
+
+	// Folds new compute timings into the cost per pixel
+	void UpdateDispatchCost();
+	uint32_t GetDynamicWidth();
+
 private:
 	uint32_t vao, vbo;
-	Shader shader, computeShader, doubleComputeShader;
-	uint32_t texture;
+	Shader shader;
+
+	// Compute shaders are rebuilt when the work group size changes, so they
+	// keep their sources around
+	std::unique_ptr<Shader> computeShader, doubleFloatComputeShader, doubleComputeShader, mirrorShader;
+	std::unique_ptr<Shader> computeAtlasShader, doubleAtlasShader;
+	std::unique_ptr<ProgramCache> programCache;
+	std::string escapeTimeSource, doubleFloatSource, mirrorSource;
+	int workGroupSize[2];
+
+	GpuTimer computeTimer, renderTimer;
+
+	// The texture on screen and the one being calculated take turns, so
+	// the compute shader never has to wait for the draw or the other way
+	// around. The third is the target when pixels are copied from the last
+	// result while that's still on screen.
+	static constexpr uint32_t TextureCount = 3;
+	uint32_t textures[TextureCount];
+	uint32_t currentTexture;
+	uint32_t displayedTexture;
+
+	// Texture written by the batch of slices behind sliceFence
+	uint32_t fenceTexture;
+
+	// Whether batches of the current view may be shown before it's
+	// complete, which needs the rest of its texture to hold a sensible image
+	bool showPartialView;
+
+	// Each texture keeps its size until it's the target of a calculation
+	// again, the one on screen is never re-created
+	int textureSizes[TextureCount][2];
+	size_t statePixels;
+	uint32_t paletteTexture;
+	uint32_t uploadedPalette;
+
+	// Last z of every pixel, only valid if every pixel was calculated with
+	// the current view
+	uint32_t stateBuffer;
+	bool stateValid;
 
 	JuliaProperties properties;
+	JuliaProperties calculatedProperties;
+	JuliaDomain calculatedDomain;
+	bool upToDate;
+	bool panReuse;
+	bool resumeIterations;
+	bool symmetry;
+
+	std::unique_ptr<TileCache> tileCache;
+	bool cacheTiles;
+
+	// Tiles of the last dispatch that lie completely inside the texture,
+	// they're read back and stored once it finished
+	TileGrid cacheGrid;
+	std::vector<std::pair<TileKey, Tile>> uncachedTiles;
+	std::vector<uint32_t> cachedIterations;
+	std::vector<float> cachedCounts;
+
+	// Tiles being read back, one after the other in readbackBuffer, and the
+	// GLsync that signals when they arrived
+	std::vector<std::pair<TileKey, Tile>> readbackTiles;
+	uint32_t readbackBuffer;
+	void* readbackFence;
+
+	bool dynamicResolution;
+	bool interacting;
+	float targetFrameTime;
+
+	// Milliseconds of compute time per dispatched pixel and iteration
+	double pixelCost;
+	uint64_t costResultCount;
+	uint32_t dynamicWidth;
+
+	// The view that's being dispatched slice by slice
+	std::deque<Tile> pendingSlices;
+	Precision slicePrecision;
+	JuliaDomain sliceDomain;
+	bool sliceResume;
+	uint32_t resumeIteration;
+	bool pendingMirror;
+	int32_t mirrorOffset[2];
+	Tile mirrorRegion;
+
+	// GLsync of the last batch of slices, once it's signaled the batch's
+	// texture is displayed and the next batch can go
+	void* sliceFence;
+
+	// Thumbnails of the last CalculateAtlas() call, and the c of each
+	uint32_t atlasTexture;
+	uint32_t atlasBuffer;
+	std::vector<std::array<float, 2>> atlasCValues;
+	uint32_t atlasColumns;
+	uint32_t atlasSize[2];
+	bool showAtlas;
+
 	WorkProperties workProperties;
 };
\ No newline at end of file
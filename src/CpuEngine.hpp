@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "JuliaProperties.hpp"
+#include "TileScheduler.hpp"
+
+// Common interface of the engines that turn JuliaProperties into iteration
+// counts on the CPU. The result is one count per pixel, row by row starting
+// at yMin, with InteriorIterations for points that never escape.
+class CpuEngine
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	CpuEngine(uint32_t threadCount) : scheduler(threadCount), width(0), height(0) {}
+	virtual ~CpuEngine() = default;
+
+	virtual void CalculateJuliaSet(const JuliaProperties& properties) = 0;
+	virtual const char* GetName() const = 0;
+
+	// The name and every setting that changes the result, so results of
+	// different configurations can be told apart
+	virtual std::string GetDescription() const { return GetName(); }
+
+	// Whether the pixels of a view only depend on their own position, so a
+	// tile rendered on its own matches the same pixels of the whole view.
+	// Tile caches and tiled exports only work with such engines.
+	virtual bool IsTileLocal() const { return true; }
+
+	inline const std::vector<uint32_t>& GetIterations() const { return iterations; }
+	inline uint32_t GetWidth() const { return width; }
+	inline uint32_t GetHeight() const { return height; }
+	inline uint32_t GetThreadCount() const { return scheduler.GetThreadCount(); }
+	inline const SchedulerStats& GetSchedulerStats() const { return scheduler.GetStats(); }
+
+protected:
+	TileScheduler scheduler;
+	uint32_t width, height;
+	std::vector<uint32_t> iterations;
+};
@@ -0,0 +1,170 @@
+#include "CpuRenderer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+CpuRenderer::CpuRenderer(uint32_t threadCount) :
+	CpuEngine(threadCount), instructionSet(DetectInstructionSet()), tileSize(64), panReuse(true), resumeIterations(true), symmetry(true),
+	stateValid(false)
+{
+}
+
+void CpuRenderer::SetInstructionSet(InstructionSet isa)
+{
+	// Throws if the CPU doesn't support it
+	GetRowKernel(isa, false);
+
+	instructionSet = isa;
+}
+
+void CpuRenderer::SetResumeIterations(bool enabled)
+{
+	resumeIterations = enabled;
+	stateValid = false;
+
+	if (!enabled)
+	{
+		stateX = std::vector<double>();
+		stateY = std::vector<double>();
+	}
+}
+
+void CpuRenderer::CalculateJuliaSet(const JuliaProperties& properties)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+	RowKernel kernel = GetRowKernel(instructionSet, properties.precision != Precision::Single);
+
+	// Continue iterating the pixels that haven't escaped yet, only calculate
+	// what panning revealed, or calculate everything
+	std::vector<Tile> regions;
+	int32_t shiftX, shiftY;
+	bool resume = false;
+	uint32_t firstIteration = 0;
+	if (resumeIterations && stateValid && CanResumeIterations(calculatedProperties, properties))
+	{
+		regions.push_back({ 0, 0, width, height });
+		domain = calculatedDomain;
+		resume = true;
+		firstIteration = calculatedProperties.maxIterations;
+	}
+	else if (panReuse && !iterations.empty() && GetPixelShift(calculatedProperties, properties, shiftX, shiftY))
+	{
+		ShiftIterations(shiftX, shiftY);
+		regions = GetExposedStrips(width, height, shiftX, shiftY);
+
+		// Stay on the pixel grid of the reused pixels, otherwise rounding
+		// errors in the properties would show up as seams between them and
+		// the new strips
+		domain = ShiftJuliaDomain(calculatedDomain, shiftX, shiftY);
+
+		// The stored z only covers the new strips now
+		stateValid = false;
+	}
+	else
+	{
+		width = domain.width;
+		height = domain.height;
+		iterations.assign((size_t)width * height, 0);
+		regions.push_back({ 0, 0, width, height });
+
+		if (resumeIterations)
+		{
+			stateX.assign((size_t)width * height, 0.0);
+			stateY.assign((size_t)width * height, 0.0);
+			stateValid = true;
+		}
+	}
+
+	// Leave out the pixels that can be copied from their mirror image. Panning
+	// only calculates thin strips, those aren't worth it.
+	int32_t mirrorX, mirrorY;
+	Tile mirrored;
+	bool fullImage = regions.size() == 1 && regions[0].width == width && regions[0].height == height;
+	bool mirror = symmetry && fullImage && GetMirrorSymmetry(domain, mirrorX, mirrorY, mirrored);
+
+	if (mirror)
+		regions = SubtractTile(regions[0], mirrored);
+
+	scheduler.Run(regions, tileSize,
+		[&](const Tile& tile)
+		{
+			CalculateTile(kernel, domain, properties.maxIterations, resume, firstIteration, tile);
+		}
+	);
+
+	if (mirror)
+	{
+		scheduler.Run(std::vector<Tile>{ mirrored }, tileSize,
+			[&](const Tile& tile)
+			{
+				MirrorTile(mirrorX, mirrorY, tile);
+			}
+		);
+	}
+
+	calculatedProperties = properties;
+	calculatedDomain = domain;
+}
+
+void CpuRenderer::CalculateTile(RowKernel kernel, const JuliaDomain& domain, uint32_t maxIterations, bool resume, uint32_t firstIteration, const Tile& tile)
+{
+	double dx = (domain.xMax - domain.xMin) / width;
+
+	KernelRow row;
+	row.x0 = domain.xMin + tile.x * dx;
+	row.dx = dx;
+	row.c[0] = domain.c[0];
+	row.c[1] = domain.c[1];
+	row.threshold = domain.threshold;
+	row.periodicityTolerance = domain.periodicityTolerance;
+	row.maxIterations = maxIterations;
+	row.resume = resume;
+	row.firstIteration = firstIteration;
+
+	for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+	{
+		size_t first = (size_t)y * width + tile.x;
+
+		row.y = domain.yMin + y * (domain.yMax - domain.yMin) / height;
+		row.zx = stateX.empty() ? nullptr : &stateX[first];
+		row.zy = stateY.empty() ? nullptr : &stateY[first];
+		kernel(row, tile.width, &iterations[first]);
+	}
+}
+
+void CpuRenderer::ShiftIterations(int32_t shiftX, int32_t shiftY)
+{
+	if (shiftX == 0 && shiftY == 0)
+		return;
+
+	shiftedIterations.assign((size_t)width * height, 0);
+
+	// Pixel (x, y) of the new view is pixel (x + shiftX, y + shiftY) of the old one
+	uint32_t columns = width - std::abs(shiftX);
+	uint32_t rows = height - std::abs(shiftY);
+	uint32_t sourceX = std::max(shiftX, 0), sourceY = std::max(shiftY, 0);
+	uint32_t targetX = std::max(-shiftX, 0), targetY = std::max(-shiftY, 0);
+
+	for (uint32_t y = 0; y < rows; y++)
+	{
+		std::memcpy(
+			&shiftedIterations[(size_t)(targetY + y) * width + targetX],
+			&iterations[(size_t)(sourceY + y) * width + sourceX],
+			columns * sizeof(uint32_t)
+		);
+	}
+
+	iterations.swap(shiftedIterations);
+}
+
+void CpuRenderer::MirrorTile(int32_t mirrorX, int32_t mirrorY, const Tile& tile)
+{
+	for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+	{
+		uint32_t* target = &iterations[(size_t)y * width];
+		const uint32_t* source = &iterations[(size_t)(mirrorY - y) * width];
+
+		for (uint32_t x = tile.x; x < tile.x + tile.width; x++)
+			target[x] = source[mirrorX - x];
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "CpuEngine.hpp"
+#include "SimdKernel.hpp"
+
+// Computes Julia sets on the CPU by iterating every pixel, without a window
+// or GL context
+class CpuRenderer : public CpuEngine
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	CpuRenderer(uint32_t threadCount = 0);
+
+	void CalculateJuliaSet(const JuliaProperties& properties) override;
+	inline const char* GetName() const override { return "escape-time"; }
+
+	// Defaults to the widest instruction set the CPU supports
+	void SetInstructionSet(InstructionSet isa);
+
+	// Edge length of the tiles handed to the worker threads
+	inline void SetTileSize(uint32_t size) { tileSize = size; }
+
+	// If the view only moved by whole pixels since the last call, keep the
+	// pixels that are still visible and only calculate the new edges
+	inline void SetPanReuse(bool enabled) { panReuse = enabled; }
+
+	// Keep the last z of every pixel that didn't escape, so raising
+	// maxIterations only continues iterating those pixels. Costs two doubles
+	// per pixel.
+	void SetResumeIterations(bool enabled);
+
+	// If the image overlaps its own mirror image under z -> -z, only
+	// calculate one half of the overlap and copy the other. Mirrored pixels
+	// get no stored z, so the next call can't resume.
+	inline void SetSymmetry(bool enabled) { symmetry = enabled; stateValid = false; }
+
+	inline InstructionSet GetInstructionSet() const { return instructionSet; }
+	inline uint32_t GetTileSize() const { return tileSize; }
+
+private:
+	void CalculateTile(RowKernel kernel, const JuliaDomain& domain, uint32_t maxIterations, bool resume, uint32_t firstIteration, const Tile& tile);
+	void ShiftIterations(int32_t shiftX, int32_t shiftY);
+	void MirrorTile(int32_t mirrorX, int32_t mirrorY, const Tile& tile);
+
+private:
+	InstructionSet instructionSet;
+	uint32_t tileSize;
+	bool panReuse;
+	bool resumeIterations;
+	bool symmetry;
+
+	std::vector<uint32_t> shiftedIterations;
+	JuliaProperties calculatedProperties;
+	JuliaDomain calculatedDomain;
+
+	// Last z of every pixel, only valid if every pixel was calculated with
+	// the current view
+	std::vector<double> stateX, stateY;
+	bool stateValid;
+};
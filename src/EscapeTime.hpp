@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+// Iteration count stored for points that did not escape within maxIterations
+constexpr uint32_t InteriorIterations = 0xFFFFFFFF;
+
+// Iterates z = z^2 + c starting at z and returns the iteration at which |z|
+// exceeded the threshold. This is the CPU equivalent of the loop in the
+// compute shader. Counting starts at firstIteration, and z is left at its
+// last value so a later call can pick up where this one stopped.
+// With a periodicity tolerance above 0, points that get caught in an
+// attracting cycle are classified as interior as soon as that's detected.
+template<typename Real>
+inline uint32_t EscapeTime(Real& zx, Real& zy, Real cx, Real cy, Real threshold, Real periodicityTolerance, uint32_t firstIteration, uint32_t maxIterations)
+{
+	Real thresholdSquared = threshold * threshold;
+	Real toleranceSquared = periodicityTolerance * periodicityTolerance;
+
+	// Brent's cycle detection: z is compared against a saved z, which is
+	// replaced after 1, 2, 4, 8, ... iterations. That finds cycles of any
+	// length without knowing it in advance.
+	Real savedX = zx, savedY = zy;
+	uint32_t saveInterval = 1, sinceSave = 0;
+
+	for (uint32_t i = firstIteration; i < maxIterations; i++)
+	{
+		if (zx * zx + zy * zy > thresholdSquared)
+			return i;
+
+		Real x = zx * zx - zy * zy + cx;
+		zy = 2 * zx * zy + cy;
+		zx = x;
+
+		if (toleranceSquared > 0)
+		{
+			Real dx = zx - savedX;
+			Real dy = zy - savedY;
+			if (dx * dx + dy * dy < toleranceSquared)
+				return InteriorIterations;
+
+			if (++sinceSave == saveInterval)
+			{
+				savedX = zx;
+				savedY = zy;
+				sinceSave = 0;
+				saveInterval *= 2;
+			}
+		}
+	}
+
+	return InteriorIterations;
+}
+
+template<typename Real>
+inline uint32_t EscapeTime(Real zx, Real zy, Real cx, Real cy, Real threshold, uint32_t maxIterations)
+{
+	return EscapeTime<Real>(zx, zy, cx, cy, threshold, 0, 0, maxIterations);
+}
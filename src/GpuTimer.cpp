@@ -0,0 +1,117 @@
+#include "GpuTimer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+// Samples shown in the histograms
+static const size_t HistorySize = 120;
+
+// Older trace events are dropped, so a long session doesn't grow forever
+static const size_t MaxEvents = 10000;
+
+// Microseconds since the first timer was created
+static double Now()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+GpuTimer::GpuTimer(const std::string& name) :
+	name(name), queries{ 0, 0 }, pending{ false, false }, beginTime{ 0.0, 0.0 }, work{ 0.0, 0.0 }, current(0),
+	history(HistorySize, 0.0f), historyOffset(0), latest(0.0f), latestWork(0.0), resultCount(0)
+{
+	glGenQueries(2, queries);
+	Now();
+}
+
+GpuTimer::~GpuTimer()
+{
+	glDeleteQueries(2, queries);
+}
+
+void GpuTimer::Begin(double work)
+{
+	// The slot was used two timings ago. If its result still isn't there
+	// it's dropped instead of waiting for it.
+	Read(current);
+	pending[current] = false;
+
+	beginTime[current] = Now();
+	this->work[current] = work;
+	glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+
+void GpuTimer::End()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+
+	pending[current] = true;
+	current = 1 - current;
+}
+
+void GpuTimer::Collect()
+{
+	// The older query first, to keep the history in order
+	Read(current);
+	Read(1 - current);
+}
+
+void GpuTimer::Read(int slot)
+{
+	if (!pending[slot])
+		return;
+
+	GLint available = 0;
+	glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	pending[slot] = false;
+
+	latest = (float)(nanoseconds / 1e6);
+	latestWork = work[slot];
+	resultCount++;
+	history[historyOffset] = latest;
+	historyOffset = (historyOffset + 1) % HistorySize;
+
+	if (events.size() >= MaxEvents)
+		events.erase(events.begin(), events.begin() + MaxEvents / 2);
+
+	events.push_back({ beginTime[slot], nanoseconds / 1e3 });
+}
+
+void WriteChromeTrace(const std::string& path, const std::vector<const GpuTimer*>& timers)
+{
+	std::ofstream file(path);
+	if (!file)
+		throw std::runtime_error("Failed to open " + path);
+
+	// Complete ("X") events with a thread id per timer, the name is set with
+	// a metadata event so every track is labelled
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+	for (size_t i = 0; i < timers.size(); i++)
+	{
+		const GpuTimer& timer = *timers[i];
+
+		file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i + 1
+			<< ",\"args\":{\"name\":\"" << timer.GetName() << "\"}}";
+		first = false;
+
+		for (const TraceEvent& event : timer.GetEvents())
+		{
+			file << ",\n{\"name\":\"" << timer.GetName() << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i + 1
+				<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+		}
+	}
+
+	file << "\n]}\n";
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One span of GPU time in a Chrome trace, in microseconds
+struct TraceEvent
+{
+	double start, duration;
+};
+
+// Measures how long the GPU spends on the commands between Begin() and End()
+// with GL_TIME_ELAPSED queries. There are two query objects that take turns,
+// so reading a result never waits for the GPU: results show up a frame or
+// two later, once Collect() finds them available.
+// Only one timer can be running at a time, GL doesn't allow nesting them.
+class GpuTimer
+{
+public:
+	GpuTimer(const std::string& name);
+	~GpuTimer();
+
+	// The amount of work that's measured, e.g. a pixel count, comes back
+	// with the result so it can be matched to it
+	void Begin(double work = 0.0);
+	void End();
+
+	// Picks up the results that are ready, call once per frame
+	void Collect();
+
+	inline const std::string& GetName() const { return name; }
+
+	// The most recent results in milliseconds, oldest first when read from
+	// GetHistoryOffset() on (the layout ImGui::PlotHistogram expects)
+	inline const std::vector<float>& GetHistory() const { return history; }
+	inline int GetHistoryOffset() const { return (int)historyOffset; }
+	inline float GetLatest() const { return latest; }
+	inline double GetLatestWork() const { return latestWork; }
+
+	// Goes up by one for every result, to tell whether GetLatest() is new
+	inline uint64_t GetResultCount() const { return resultCount; }
+
+	inline const std::vector<TraceEvent>& GetEvents() const { return events; }
+
+private:
+	void Read(int slot);
+
+private:
+	std::string name;
+	uint32_t queries[2];
+	bool pending[2];
+
+	// CPU time at Begin(), the GPU only reports durations
+	double beginTime[2];
+	double work[2];
+	int current;
+
+	std::vector<float> history;
+	size_t historyOffset;
+	float latest;
+	double latestWork;
+	uint64_t resultCount;
+	std::vector<TraceEvent> events;
+};
+
+// Writes the events of the timers as a Chrome trace (chrome://tracing or
+// ui.perfetto.dev), one track per timer
+void WriteChromeTrace(const std::string& path, const std::vector<const GpuTimer*>& timers);
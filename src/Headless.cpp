@@ -0,0 +1,444 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+#include <memory>
+
+#include "CpuRenderer.hpp"
+#include "MarianiSilver.hpp"
+#include "Perturbation.hpp"
+#include "InverseIteration.hpp"
+#include "Supersampler.hpp"
+#include "Animation.hpp"
+#include "TiledExport.hpp"
+#include "CachedEngine.hpp"
+#include "Atlas.hpp"
+#include "Image.hpp"
+#include "Palette.hpp"
+
+static void PrintUsage()
+{
+	std::cerr <<
+		"Usage: julia_headless <output.ppm> [options]\n"
+		"       julia_headless <frame_%05d.png> --frames <n> [options]\n"
+		"       julia_headless <poster.jtiles> [options]\n"
+		"       julia_headless <atlas.ppm> --atlas <columns> <rows> [options]\n"
+		"  --width <n>            Image width in pixels (default 1920)\n"
+		"  --aspect <f>           Height / width (default 0.5625)\n"
+		"  --iterations <n>       Max iterations (default 100)\n"
+		"  --cutoff <f>           Color threshold (default 100)\n"
+		"  --palette <name>       Classic, Fire, Ocean or Grayscale (default Classic)\n"
+		"  --c <x> <y>            The constant c (default -0.835 -0.2321)\n"
+		"  --polar                Interpret c as r and phi\n"
+		"  --bounds <min> <max>   Domain in x direction (default -2.5 2.5)\n"
+		"  --ycenter <f>          Center of the domain in y direction (default 0)\n"
+		"  --double               Use double precision\n"
+		"  --periodicity          Stop iterating points caught in an attracting cycle\n"
+		"  --threads <n>          Worker threads, 0 = all (default 0)\n"
+		"  --isa <name>           scalar, avx2 or avx512 (default: best supported)\n"
+		"  --tile-size <n>        Edge length of the tiles given to the threads (default 64)\n"
+		"  --engine <name>        escape-time, mariani-silver, perturbation or inverse-iteration\n"
+		"                         (default escape-time)\n"
+		"  --center <x> <y>       Decimal center of a deep zoom view, perturbation only\n"
+		"  --view-width <f>       Width of the deep zoom view in the complex plane\n"
+		"  --supersample <n>      Up to n samples for pixels that differ strongly from a neighbour\n"
+		"                         (multiple of 4)\n"
+		"  --max-hits <n>         Hits per pixel before inverse iteration stops there (default 8)\n"
+		"  --stats                Print per thread scheduling statistics\n"
+		"  --export-tile <n>      Tile size of .jtiles exports (default 2048)\n"
+		"  --cache <file>         Keep calculated tiles in this file and reuse them\n"
+		"Atlases have one thumbnail of --width pixels per c on a grid over the c-plane:\n"
+		"  --atlas <cols> <rows>  Size of the grid\n"
+		"  --c-range <xmin> <xmax> <ymin> <ymax> Part of the c-plane covered (default -1.5 1.5 -1.5 1.5)\n"
+		"Animations go from the options above to these end values:\n"
+		"  --frames <n>           Number of frames, the output path needs a %d\n"
+		"  --c-end <x> <y>        c of the last frame, in the same coordinates as --c\n"
+		"  --bounds-end <min> <max> Domain in x direction of the last frame\n"
+		"  --ycenter-end <f>      Center in y direction of the last frame\n"
+		"  --iterations-end <n>   Max iterations of the last frame\n";
+}
+
+int main(int argc, char** argv)
+{
+	// The output path comes first, an option there is most likely --help
+	std::string first = argc < 2 ? "" : argv[1];
+	if (first.empty() || first.rfind("--", 0) == 0)
+	{
+		PrintUsage();
+		return first == "--help" ? 0 : -1;
+	}
+
+	// Same defaults as the interactive canvas
+	JuliaProperties properties;
+	properties.xBounds[0] = -2.5f;
+	properties.xBounds[1] = 2.5f;
+	properties.yCenter = 0.0f;
+	properties.aspectRatio = 9.0f / 16.0f;
+	properties.textureWidth = 1920;
+	properties.maxIterations = 100;
+	properties.iterationColorCutoff = 100.0f;
+	properties.palette = 0;
+	properties.c[0] = -0.835f;
+	properties.c[1] = -0.2321f;
+	properties.precision = Precision::Single;
+	properties.isPolar = false;
+	properties.periodicityCheck = false;
+
+	std::string outputPath = first;
+	uint32_t threadCount = 0;
+	InstructionSet isa = DetectInstructionSet();
+	uint32_t tileSize = 64;
+	std::string engineName = "escape-time";
+	std::string center[2];
+	double viewWidth = 0.0;
+	uint32_t maxHits = 0;
+	uint32_t maxSamples = 0;
+	bool printStats = false;
+	std::string cachePath;
+	uint32_t atlasSize[2] = { 0, 0 };
+	double cRange[4] = { -1.5, 1.5, -1.5, 1.5 };
+
+	// Everything that isn't set explicitly ends where it started
+	uint32_t frameCount = 0;
+	uint32_t exportTileSize = 2048;
+	JuliaProperties endProperties = {};
+	bool endSet[4] = { false, false, false, false };
+
+	try
+	{
+		for (int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+
+			// Returns the next argument, or throws if there isn't one
+			auto next = [&]() -> std::string
+			{
+				if (i + 1 >= argc)
+					throw std::runtime_error("Missing value for " + arg);
+
+				return argv[++i];
+			};
+
+			if (arg == "--width")
+				properties.textureWidth = std::stoul(next());
+			else if (arg == "--aspect")
+				properties.aspectRatio = std::stof(next());
+			else if (arg == "--iterations")
+				properties.maxIterations = std::stoul(next());
+			else if (arg == "--cutoff")
+				properties.iterationColorCutoff = std::stof(next());
+			else if (arg == "--palette")
+			{
+				std::string name = next();
+				const std::vector<Palette>& palettes = GetPalettes();
+
+				properties.palette = (uint32_t)palettes.size();
+				for (uint32_t p = 0; p < palettes.size(); p++)
+				{
+					if (palettes[p].name == name)
+						properties.palette = p;
+				}
+
+				if (properties.palette == palettes.size())
+					throw std::runtime_error("Unknown palette " + name);
+			}
+			else if (arg == "--c")
+			{
+				properties.c[0] = std::stof(next());
+				properties.c[1] = std::stof(next());
+			}
+			else if (arg == "--polar")
+				properties.isPolar = true;
+			else if (arg == "--bounds")
+			{
+				properties.xBounds[0] = std::stod(next());
+				properties.xBounds[1] = std::stod(next());
+			}
+			else if (arg == "--ycenter")
+				properties.yCenter = std::stod(next());
+			else if (arg == "--double")
+				properties.precision = Precision::Double;
+			else if (arg == "--periodicity")
+				properties.periodicityCheck = true;
+			else if (arg == "--threads")
+				threadCount = std::stoul(next());
+			else if (arg == "--isa")
+			{
+				std::string name = next();
+				if (name == "scalar")
+					isa = InstructionSet::Scalar;
+				else if (name == "avx2")
+					isa = InstructionSet::AVX2;
+				else if (name == "avx512")
+					isa = InstructionSet::AVX512;
+				else
+					throw std::runtime_error("Unknown instruction set " + name);
+			}
+			else if (arg == "--tile-size")
+				tileSize = std::stoul(next());
+			else if (arg == "--engine")
+				engineName = next();
+			else if (arg == "--center")
+			{
+				center[0] = next();
+				center[1] = next();
+			}
+			else if (arg == "--view-width")
+				viewWidth = std::stod(next());
+			else if (arg == "--supersample")
+				maxSamples = std::stoul(next());
+			else if (arg == "--max-hits")
+				maxHits = std::stoul(next());
+			else if (arg == "--stats")
+				printStats = true;
+			else if (arg == "--export-tile")
+				exportTileSize = std::stoul(next());
+			else if (arg == "--atlas")
+			{
+				atlasSize[0] = std::stoul(next());
+				atlasSize[1] = std::stoul(next());
+			}
+			else if (arg == "--c-range")
+			{
+				for (double& value : cRange)
+					value = std::stod(next());
+			}
+			else if (arg == "--cache")
+				cachePath = next();
+			else if (arg == "--frames")
+				frameCount = std::stoul(next());
+			else if (arg == "--c-end")
+			{
+				endProperties.c[0] = std::stof(next());
+				endProperties.c[1] = std::stof(next());
+				endSet[0] = true;
+			}
+			else if (arg == "--bounds-end")
+			{
+				endProperties.xBounds[0] = std::stod(next());
+				endProperties.xBounds[1] = std::stod(next());
+				endSet[1] = true;
+			}
+			else if (arg == "--ycenter-end")
+			{
+				endProperties.yCenter = std::stod(next());
+				endSet[2] = true;
+			}
+			else if (arg == "--iterations-end")
+			{
+				endProperties.maxIterations = std::stoul(next());
+				endSet[3] = true;
+			}
+			else
+				throw std::runtime_error("Unknown option " + arg);
+		}
+
+		// All thumbnails in one job, independent of the engines
+		if (atlasSize[0] > 0 && atlasSize[1] > 0)
+		{
+			if (maxSamples > 0)
+				throw std::runtime_error("--supersample doesn't work with --atlas");
+
+			AtlasRenderer atlas(threadCount);
+			atlas.SetInstructionSet(isa);
+
+			auto start = std::chrono::steady_clock::now();
+			atlas.CalculateAtlas(properties, MakeCGrid(atlasSize[0], atlasSize[1], cRange[0], cRange[1], cRange[2], cRange[3]), atlasSize[0]);
+			auto end = std::chrono::steady_clock::now();
+
+			std::vector<uint8_t> rgb;
+			ColorizeIterations(properties, atlas.GetIterations(), rgb);
+			WritePPM(outputPath, atlas.GetWidth(), atlas.GetHeight(), rgb);
+
+			std::cout << "Rendered a " << atlasSize[0] << "x" << atlasSize[1] << " atlas (" << atlas.GetWidth() << "x" << atlas.GetHeight()
+				<< ") on " << atlas.GetThreadCount() << " threads in " << std::chrono::duration<double, std::milli>(end - start).count()
+				<< " ms" << std::endl;
+			return 0;
+		}
+
+		std::unique_ptr<CpuEngine> engine;
+		MarianiSilverRenderer* marianiSilver = nullptr;
+		PerturbationRenderer* perturbation = nullptr;
+		InverseIterationRenderer* inverseIteration = nullptr;
+		if (engineName == "escape-time")
+		{
+			CpuRenderer* renderer = new CpuRenderer(threadCount);
+			renderer->SetInstructionSet(isa);
+			renderer->SetTileSize(tileSize);
+			engine.reset(renderer);
+		}
+		else if (engineName == "mariani-silver")
+		{
+			marianiSilver = new MarianiSilverRenderer(threadCount);
+			engine.reset(marianiSilver);
+		}
+		else if (engineName == "perturbation")
+		{
+			perturbation = new PerturbationRenderer(threadCount);
+			perturbation->SetTileSize(tileSize);
+			if (!center[0].empty())
+			{
+				if (viewWidth <= 0.0)
+					throw std::runtime_error("--center needs a --view-width");
+
+				perturbation->SetView(center[0], center[1], viewWidth);
+			}
+
+			engine.reset(perturbation);
+		}
+		else if (engineName == "inverse-iteration")
+		{
+			inverseIteration = new InverseIterationRenderer(threadCount);
+			if (maxHits > 0)
+				inverseIteration->SetMaxHits(maxHits);
+
+			engine.reset(inverseIteration);
+		}
+		else
+			throw std::runtime_error("Unknown engine " + engineName);
+
+		// The cache goes in front of whichever engine was picked
+		std::unique_ptr<TileCache> cache;
+		std::unique_ptr<CachedEngine> cachedEngine;
+		if (!cachePath.empty())
+		{
+			if (!center[0].empty() || inverseIteration != nullptr)
+				throw std::runtime_error("--cache doesn't work with --center or inverse-iteration");
+
+			cache.reset(new TileCache(256, cachePath, 1024));
+			cachedEngine.reset(new CachedEngine(*engine, *cache));
+		}
+
+		CpuEngine& renderer = cachedEngine ? *cachedEngine : *engine;
+
+		// Subsamples are calculated from the properties, not by the engine
+		bool tiledExport = outputPath.size() > 7 && outputPath.substr(outputPath.size() - 7) == ".jtiles";
+		if (maxSamples > 0 && (inverseIteration != nullptr || !center[0].empty() || frameCount > 0 || tiledExport))
+			throw std::runtime_error("--supersample only works for single images without --center, and not with inverse-iteration");
+
+		// Tiles rendered one by one would differ from the whole image
+		if (tiledExport && (inverseIteration != nullptr || !center[0].empty()))
+			throw std::runtime_error(".jtiles output doesn't work with --center or inverse-iteration");
+
+		// Images of any size, rendered tile by tile straight to disk
+		if (tiledExport)
+		{
+			TiledExportSettings settings;
+			settings.width = properties.textureWidth;
+			settings.height = (uint64_t)((double)properties.textureWidth * properties.aspectRatio);
+			settings.tileSize = exportTileSize;
+
+			TiledExportStats stats = ExportTiled(renderer, properties, settings, outputPath);
+
+			std::cout << "Exported " << settings.width << "x" << settings.height << " in " << stats.tileCount << " tiles ("
+				<< stats.resumedTiles << " from an earlier run) in " << stats.wallMilliseconds << " ms" << std::endl;
+			return 0;
+		}
+
+		if (frameCount > 0)
+		{
+			JuliaProperties last = properties;
+			if (endSet[0])
+			{
+				last.c[0] = endProperties.c[0];
+				last.c[1] = endProperties.c[1];
+			}
+			if (endSet[1])
+			{
+				last.xBounds[0] = endProperties.xBounds[0];
+				last.xBounds[1] = endProperties.xBounds[1];
+			}
+			if (endSet[2])
+				last.yCenter = endProperties.yCenter;
+			if (endSet[3])
+				last.maxIterations = endProperties.maxIterations;
+
+			AnimationSettings settings;
+			settings.frameCount = frameCount;
+			settings.outputPattern = outputPath;
+			settings.queueSize = 4;
+
+			AnimationStats stats = RenderAnimation(renderer, { { 0.0, properties }, { 1.0, last } }, settings);
+
+			std::cout << "Rendered " << frameCount << " frames in " << stats.wallMilliseconds << " ms (compute "
+				<< stats.computeMilliseconds << " ms, colorize " << stats.colorizeMilliseconds << " ms, encode "
+				<< stats.encodeMilliseconds << " ms, write " << stats.writeMilliseconds << " ms)" << std::endl;
+			return 0;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		renderer.CalculateJuliaSet(properties);
+		auto end = std::chrono::steady_clock::now();
+
+		std::vector<uint8_t> rgb;
+		ColorizeIterations(properties, renderer.GetIterations(), rgb);
+
+		BoundarySupersampler supersampler(threadCount);
+		double supersampleMilliseconds = 0.0;
+		if (maxSamples > 0)
+		{
+			auto supersampleStart = std::chrono::steady_clock::now();
+			supersampler.SetInstructionSet(isa);
+			supersampler.SetMaxSamples(maxSamples);
+			supersampler.Supersample(properties, renderer.GetIterations(), rgb);
+			supersampleMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - supersampleStart).count();
+		}
+
+		WritePPM(outputPath, renderer.GetWidth(), renderer.GetHeight(), rgb);
+
+		std::cout << "Rendered " << renderer.GetWidth() << "x" << renderer.GetHeight()
+			<< " on " << engine->GetThreadCount() << " threads (" << renderer.GetName()
+			<< (engineName == "escape-time" ? std::string(", ") + GetInstructionSetName(isa) : "") << ") in "
+			<< std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+		if (maxSamples > 0)
+		{
+			std::cout << "Supersampled " << supersampler.GetRefinedPixels() << " pixels with " << supersampler.GetSampleCount()
+				<< " samples in " << supersampleMilliseconds << " ms" << std::endl;
+		}
+
+		if (cachedEngine)
+		{
+			TileCacheStats stats = cache->GetStats();
+			std::cout << "Took " << cachedEngine->GetCachedTiles() << " tiles from the cache (" << stats.memoryHits << " from memory, "
+				<< stats.diskHits << " from disk), calculated " << cachedEngine->GetCalculatedTiles() << std::endl;
+		}
+
+		// With a cache these would only describe the last tile
+		if (marianiSilver != nullptr && !cachedEngine)
+		{
+			uint64_t pixelCount = (uint64_t)renderer.GetWidth() * renderer.GetHeight();
+			std::cout << "Filled " << marianiSilver->GetSkippedPixels() << " of " << pixelCount
+				<< " pixels without calculating them" << std::endl;
+		}
+
+		if (perturbation != nullptr && !cachedEngine)
+		{
+			std::cout << "Used " << perturbation->GetReferenceCount() << " reference orbits, "
+				<< perturbation->GetGlitchedPixels() << " pixels still glitched" << std::endl;
+		}
+
+		if (inverseIteration != nullptr && !cachedEngine)
+			std::cout << "Pulled back " << inverseIteration->GetPointCount() << " points" << std::endl;
+
+		if (printStats)
+		{
+			const SchedulerStats& stats = engine->GetSchedulerStats();
+			for (size_t i = 0; i < stats.workers.size(); i++)
+			{
+				const WorkerStats& worker = stats.workers[i];
+				std::cout << "Thread " << i << ": " << worker.tilesProcessed << " tiles, "
+					<< worker.tilesStolen << " stolen, "
+					<< worker.busyMilliseconds << " ms busy, "
+					<< worker.idleMilliseconds << " ms idle" << std::endl;
+			}
+		}
+	}
+	catch (const std::exception& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,254 @@
+#include "HighPrecision.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+HighPrecision::HighPrecision(uint32_t fractionLimbs) :
+	fractionLimbs(fractionLimbs), negative(false), limbs(fractionLimbs + 1, 0)
+{
+}
+
+HighPrecision::HighPrecision(double value, uint32_t fractionLimbs) :
+	HighPrecision(fractionLimbs)
+{
+	negative = value < 0.0;
+
+	// Peel off one limb at a time, starting at the integer part. Scaling by
+	// powers of two and subtracting the whole part are exact.
+	double remainder = std::fabs(value);
+	for (int32_t i = (int32_t)fractionLimbs; i >= 0; i--)
+	{
+		double scale = std::ldexp(1.0, 32 * (i - (int32_t)fractionLimbs));
+		double limb = std::floor(remainder / scale);
+		limbs[i] = (uint32_t)std::fmin(limb, 4294967295.0);
+		remainder -= limbs[i] * scale;
+	}
+
+	if (IsZero())
+		negative = false;
+}
+
+HighPrecision HighPrecision::FromString(const std::string& text, uint32_t fractionLimbs)
+{
+	size_t position = 0;
+	bool negative = false;
+	if (position < text.size() && (text[position] == '-' || text[position] == '+'))
+		negative = text[position++] == '-';
+
+	std::string integerDigits, fractionDigits;
+	while (position < text.size() && std::isdigit((unsigned char)text[position]))
+		integerDigits += text[position++];
+
+	if (position < text.size() && text[position] == '.')
+	{
+		position++;
+		while (position < text.size() && std::isdigit((unsigned char)text[position]))
+			fractionDigits += text[position++];
+	}
+
+	if (integerDigits.empty() && fractionDigits.empty())
+		throw std::runtime_error("Not a number: " + text);
+
+	int32_t exponent = 0;
+	if (position < text.size() && (text[position] == 'e' || text[position] == 'E'))
+	{
+		size_t used = 0;
+		try
+		{
+			exponent = std::stoi(text.substr(position + 1), &used);
+		}
+		catch (const std::exception&)
+		{
+			throw std::runtime_error("Not a number: " + text);
+		}
+
+		position += used + 1;
+	}
+
+	if (position != text.size())
+		throw std::runtime_error("Not a number: " + text);
+
+	// The fraction is built from its last digit forwards, every digit is
+	// added and the sum shifted one decimal place to the right
+	HighPrecision result(fractionLimbs);
+	for (size_t i = fractionDigits.size(); i > 0; i--)
+	{
+		result.limbs[fractionLimbs] += fractionDigits[i - 1] - '0';
+		result.DivideSmall(10);
+	}
+
+	uint32_t integerPart = 0;
+	for (char digit : integerDigits)
+	{
+		if (integerPart > 400000000)
+			throw std::runtime_error("Number out of range: " + text);
+
+		integerPart = integerPart * 10 + (digit - '0');
+	}
+	result.limbs[fractionLimbs] += integerPart;
+
+	for (int32_t i = 0; i < exponent; i++)
+	{
+		if (result.limbs[fractionLimbs] > 400000000)
+			throw std::runtime_error("Number out of range: " + text);
+
+		result.MultiplySmall(10);
+	}
+
+	for (int32_t i = 0; i > exponent; i--)
+		result.DivideSmall(10);
+
+	result.negative = negative && !result.IsZero();
+	return result;
+}
+
+uint32_t HighPrecision::LimbsForResolution(double resolution)
+{
+	// 64 guard bits on top of what the resolution needs
+	double bits = -std::log2(std::fabs(resolution)) + 64.0;
+	if (!(bits > 64.0))
+		bits = 64.0;
+
+	return (uint32_t)std::ceil(bits / 32.0);
+}
+
+double HighPrecision::ToDouble() const
+{
+	// Only the top few limbs make it into a double, but the lower ones are
+	// summed first so nothing is rounded twice
+	double value = 0.0;
+	for (uint32_t i = 0; i < limbs.size(); i++)
+		value += std::ldexp((double)limbs[i], 32 * ((int32_t)i - (int32_t)fractionLimbs));
+
+	return negative ? -value : value;
+}
+
+HighPrecision HighPrecision::operator+(const HighPrecision& other) const
+{
+	HighPrecision result = *this;
+	if (negative == other.negative)
+	{
+		result.AddMagnitude(other);
+	}
+	else if (CompareMagnitude(other) >= 0)
+	{
+		result.SubtractMagnitude(other);
+	}
+	else
+	{
+		result = other;
+		result.SubtractMagnitude(*this);
+	}
+
+	if (result.IsZero())
+		result.negative = false;
+
+	return result;
+}
+
+HighPrecision HighPrecision::operator-(const HighPrecision& other) const
+{
+	return *this + (-other);
+}
+
+HighPrecision HighPrecision::operator*(const HighPrecision& other) const
+{
+	// Schoolbook multiplication into a double length product, of which the
+	// limbs below the fraction are dropped
+	size_t count = limbs.size();
+	std::vector<uint64_t> product(2 * count, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t carry = 0;
+		for (size_t j = 0; j < count; j++)
+		{
+			uint64_t sum = product[i + j] + (uint64_t)limbs[i] * other.limbs[j] + carry;
+			product[i + j] = sum & 0xFFFFFFFF;
+			carry = sum >> 32;
+		}
+
+		product[i + count] += carry;
+	}
+
+	HighPrecision result(fractionLimbs);
+	for (size_t i = 0; i < count; i++)
+		result.limbs[i] = (uint32_t)product[i + fractionLimbs];
+
+	result.negative = (negative != other.negative) && !result.IsZero();
+	return result;
+}
+
+HighPrecision HighPrecision::operator-() const
+{
+	HighPrecision result = *this;
+	result.negative = !negative && !IsZero();
+	return result;
+}
+
+int HighPrecision::CompareMagnitude(const HighPrecision& other) const
+{
+	for (size_t i = limbs.size(); i > 0; i--)
+	{
+		if (limbs[i - 1] != other.limbs[i - 1])
+			return limbs[i - 1] < other.limbs[i - 1] ? -1 : 1;
+	}
+
+	return 0;
+}
+
+void HighPrecision::AddMagnitude(const HighPrecision& other)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < limbs.size(); i++)
+	{
+		uint64_t sum = (uint64_t)limbs[i] + other.limbs[i] + carry;
+		limbs[i] = (uint32_t)sum;
+		carry = sum >> 32;
+	}
+}
+
+void HighPrecision::SubtractMagnitude(const HighPrecision& other)
+{
+	// Only called with a magnitude at least as large as the other one
+	int64_t borrow = 0;
+	for (size_t i = 0; i < limbs.size(); i++)
+	{
+		int64_t difference = (int64_t)limbs[i] - other.limbs[i] - borrow;
+		borrow = difference < 0 ? 1 : 0;
+		limbs[i] = (uint32_t)(difference + (borrow << 32));
+	}
+}
+
+bool HighPrecision::IsZero() const
+{
+	for (uint32_t limb : limbs)
+	{
+		if (limb != 0)
+			return false;
+	}
+
+	return true;
+}
+
+void HighPrecision::MultiplySmall(uint32_t factor)
+{
+	uint64_t carry = 0;
+	for (size_t i = 0; i < limbs.size(); i++)
+	{
+		uint64_t product = (uint64_t)limbs[i] * factor + carry;
+		limbs[i] = (uint32_t)product;
+		carry = product >> 32;
+	}
+}
+
+void HighPrecision::DivideSmall(uint32_t divisor)
+{
+	uint64_t remainder = 0;
+	for (size_t i = limbs.size(); i > 0; i--)
+	{
+		uint64_t current = (remainder << 32) | limbs[i - 1];
+		limbs[i - 1] = (uint32_t)(current / divisor);
+		remainder = current % divisor;
+	}
+}
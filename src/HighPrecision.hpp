@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Signed fixed point number with a configurable number of 32 bit fraction
+// limbs and one limb for the integer part. That's enough for everything the
+// reference orbit of a Julia set needs: values stay below the escape
+// threshold, and the precision only has to cover the pixel size.
+// Numbers taking part in one operation need the same number of limbs.
+class HighPrecision
+{
+public:
+	HighPrecision(uint32_t fractionLimbs = 2);
+	HighPrecision(double value, uint32_t fractionLimbs);
+
+	// Parses a decimal number like "-0.743643887037158704752191506114774"
+	// or "1.5e-20". Throws if the string isn't a number.
+	static HighPrecision FromString(const std::string& text, uint32_t fractionLimbs);
+
+	// Number of fraction limbs needed to resolve steps of the given size,
+	// plus some guard bits for the rounding error of long orbits
+	static uint32_t LimbsForResolution(double resolution);
+
+	double ToDouble() const;
+	inline uint32_t GetFractionLimbs() const { return fractionLimbs; }
+
+	HighPrecision operator+(const HighPrecision& other) const;
+	HighPrecision operator-(const HighPrecision& other) const;
+	HighPrecision operator*(const HighPrecision& other) const;
+	HighPrecision operator-() const;
+
+private:
+	// Compares the magnitudes, ignoring the sign
+	int CompareMagnitude(const HighPrecision& other) const;
+	void AddMagnitude(const HighPrecision& other);
+	void SubtractMagnitude(const HighPrecision& other);
+	bool IsZero() const;
+
+	void MultiplySmall(uint32_t factor);
+	void DivideSmall(uint32_t divisor);
+
+private:
+	uint32_t fractionLimbs;
+	bool negative;
+
+	// Magnitude, least significant limb first. The last limb is the
+	// integer part.
+	std::vector<uint32_t> limbs;
+};
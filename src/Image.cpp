@@ -0,0 +1,194 @@
+#include "Image.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "EscapeTime.hpp"
+#include "Palette.hpp"
+
+static uint8_t ToByte(float value)
+{
+	return (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static const Palette& GetPalette(const JuliaProperties& properties)
+{
+	const std::vector<Palette>& palettes = GetPalettes();
+	return palettes[properties.palette < palettes.size() ? properties.palette : 0];
+}
+
+static void ColorizeIteration(const JuliaProperties& properties, const Palette& palette, uint32_t iterations, float rgb[3])
+{
+	// Points inside the set get the first color of the palette
+	float t = 0.0f;
+	if (iterations != InteriorIterations)
+		t = (float)iterations / properties.iterationColorCutoff;
+
+	SamplePalette(palette, t, rgb);
+}
+
+void ColorizeIterations(const JuliaProperties& properties, const std::vector<uint32_t>& iterations, std::vector<uint8_t>& rgb)
+{
+	const Palette& palette = GetPalette(properties);
+
+	rgb.resize(iterations.size() * 3);
+
+	for (size_t i = 0; i < iterations.size(); i++)
+	{
+		float color[3];
+		ColorizeIteration(properties, palette, iterations[i], color);
+
+		rgb[3 * i + 0] = ToByte(color[0]);
+		rgb[3 * i + 1] = ToByte(color[1]);
+		rgb[3 * i + 2] = ToByte(color[2]);
+	}
+}
+
+void ColorizeIteration(const JuliaProperties& properties, uint32_t iterations, float rgb[3])
+{
+	ColorizeIteration(properties, GetPalette(properties), iterations, rgb);
+}
+
+void WritePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+	WriteFile(path, EncodePPM(width, height, rgb));
+}
+
+std::vector<uint8_t> EncodePPM(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+	std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+
+	std::vector<uint8_t> data(header.begin(), header.end());
+	data.reserve(header.size() + (size_t)width * height * 3);
+
+	// PPM stores the top row first
+	for (uint32_t y = height; y > 0; y--)
+	{
+		const uint8_t* row = &rgb[(size_t)(y - 1) * width * 3];
+		data.insert(data.end(), row, row + (size_t)width * 3);
+	}
+
+	return data;
+}
+
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const std::vector<uint32_t> table = []()
+	{
+		std::vector<uint32_t> values(256);
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+			values[n] = c;
+		}
+
+		return values;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+static void PushBigEndian(std::vector<uint8_t>& data, uint32_t value)
+{
+	data.push_back((uint8_t)(value >> 24));
+	data.push_back((uint8_t)(value >> 16));
+	data.push_back((uint8_t)(value >> 8));
+	data.push_back((uint8_t)value);
+}
+
+// Appends a chunk, the CRC covers the type and the contents
+static void PushChunk(std::vector<uint8_t>& data, const char* type, const std::vector<uint8_t>& contents)
+{
+	PushBigEndian(data, (uint32_t)contents.size());
+
+	size_t start = data.size();
+	data.insert(data.end(), type, type + 4);
+	data.insert(data.end(), contents.begin(), contents.end());
+
+	PushBigEndian(data, Crc32(&data[start], data.size() - start));
+}
+
+std::vector<uint8_t> EncodePNG(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb)
+{
+	std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	// 8 bit RGB, no interlacing
+	std::vector<uint8_t> header;
+	PushBigEndian(header, width);
+	PushBigEndian(header, height);
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+	PushChunk(png, "IHDR", header);
+
+	// Every row starts with its filter type, 0 (none). Rows go top first.
+	size_t rowSize = (size_t)width * 3 + 1;
+	std::vector<uint8_t> raw;
+	raw.reserve(rowSize * height);
+	for (uint32_t y = height; y > 0; y--)
+	{
+		const uint8_t* row = &rgb[(size_t)(y - 1) * width * 3];
+		raw.push_back(0);
+		raw.insert(raw.end(), row, row + (size_t)width * 3);
+	}
+
+	// zlib stream of stored deflate blocks, at most 65535 bytes each
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+
+	size_t position = 0;
+	do
+	{
+		size_t length = std::min<size_t>(raw.size() - position, 65535);
+		bool last = position + length == raw.size();
+
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back((uint8_t)length);
+		zlib.push_back((uint8_t)(length >> 8));
+		zlib.push_back((uint8_t)~length);
+		zlib.push_back((uint8_t)(~length >> 8));
+		zlib.insert(zlib.end(), raw.begin() + position, raw.begin() + position + length);
+
+		position += length;
+	} while (position < raw.size());
+
+	// Adler-32 of the uncompressed data. The sums are reduced every 5552
+	// bytes, the most that can't overflow 32 bits.
+	uint32_t a = 1, b = 0;
+	for (size_t i = 0; i < raw.size(); )
+	{
+		size_t end = std::min(raw.size(), i + 5552);
+		for (; i < end; i++)
+		{
+			a += raw[i];
+			b += a;
+		}
+
+		a %= 65521;
+		b %= 65521;
+	}
+	PushBigEndian(zlib, (b << 16) | a);
+
+	PushChunk(png, "IDAT", zlib);
+	PushChunk(png, "IEND", {});
+
+	return png;
+}
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		throw std::runtime_error("Failed to open " + path + " for writing");
+
+	file.write((const char*)data.data(), (std::streamsize)data.size());
+
+	if (!file)
+		throw std::runtime_error("Failed to write " + path);
+}
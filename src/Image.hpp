@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "JuliaProperties.hpp"
+
+// Turns iteration counts into 8 bit RGB pixels through the palette selected
+// in the properties, the same way the render shader does on screen
+void ColorizeIterations(const JuliaProperties& properties, const std::vector<uint32_t>& iterations, std::vector<uint8_t>& rgb);
+
+// Color of a single count, as floats between 0 and 1
+void ColorizeIteration(const JuliaProperties& properties, uint32_t iterations, float rgb[3]);
+
+// Writes 8 bit RGB pixels as a binary PPM. The first row of pixels is the
+// bottom of the image, like in an OpenGL texture.
+void WritePPM(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+
+// Encode 8 bit RGB pixels (bottom row first, like above) into a file in
+// memory. The PNG isn't compressed, its zlib stream only uses stored
+// blocks. That keeps encoding about as cheap as copying, at the cost of
+// size, and needs no zlib.
+std::vector<uint8_t> EncodePPM(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+std::vector<uint8_t> EncodePNG(uint32_t width, uint32_t height, const std::vector<uint8_t>& rgb);
+
+void WriteFile(const std::string& path, const std::vector<uint8_t>& data);
@@ -0,0 +1,128 @@
+#include "InverseIteration.hpp"
+
+#include <cmath>
+#include <complex>
+
+// Cells per side of the grid outside of the view
+static constexpr uint32_t OuterGridSize = 1024;
+
+// Preimages collected before the subtrees are handed to the worker threads
+static constexpr size_t SubtreeCount = 4096;
+static constexpr uint32_t SubtreesPerJob = 16;
+
+InverseIterationRenderer::InverseIterationRenderer(uint32_t threadCount) :
+	CpuEngine(threadCount), maxHits(8), outerCellSize(0.0), pointCount(0)
+{
+}
+
+void InverseIterationRenderer::CalculateJuliaSet(const JuliaProperties& properties)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+
+	width = domain.width;
+	height = domain.height;
+	hits = std::vector<std::atomic<uint32_t>>((size_t)width * height);
+	outerHits = std::vector<std::atomic<uint32_t>>((size_t)OuterGridSize * OuterGridSize);
+	outerCellSize = 2.0 * domain.threshold / OuterGridSize;
+
+	// The fixed points solve z^2 - z + c = 0. At least one of them is
+	// repelling (|2z| > 1), which puts it on the Julia set.
+	std::complex<double> c(domain.c[0], domain.c[1]);
+	std::complex<double> root = std::sqrt(0.25 - c);
+	std::complex<double> fixedPoint = (std::abs(0.5 + root) >= std::abs(0.5 - root)) ? 0.5 + root : 0.5 - root;
+
+	// Breadth first until there are enough subtrees to keep every thread busy
+	std::vector<Point> subtrees, next;
+	Point start = { fixedPoint.real(), fixedPoint.imag(), 0 };
+	if (Visit(start, domain))
+		subtrees.push_back(start);
+
+	uint64_t points = 1;
+	uint32_t maxDepth = properties.maxIterations;
+	while (!subtrees.empty() && subtrees.size() < SubtreeCount && subtrees[0].depth < maxDepth)
+	{
+		next.clear();
+		for (const Point& point : subtrees)
+			PushPreimages(point, domain, next);
+
+		subtrees.clear();
+		points += next.size();
+		for (const Point& point : next)
+		{
+			if (Visit(point, domain))
+				subtrees.push_back(point);
+		}
+	}
+
+	pointCount = points;
+	scheduler.Run((uint32_t)subtrees.size(), 1, SubtreesPerJob,
+		[&](const Tile& tile)
+		{
+			for (uint32_t i = tile.x; i < tile.x + tile.width; i++)
+				Traverse(subtrees[i], domain, maxDepth);
+		}
+	);
+
+	iterations.resize((size_t)width * height);
+	for (size_t i = 0; i < iterations.size(); i++)
+		iterations[i] = hits[i].load(std::memory_order_relaxed);
+}
+
+bool InverseIterationRenderer::Visit(const Point& point, const JuliaDomain& domain)
+{
+	// Pixels are centered on the points the escape time engines sample
+	double x = std::floor((point.x - domain.xMin) / (domain.xMax - domain.xMin) * width + 0.5);
+	double y = std::floor((point.y - domain.yMin) / (domain.yMax - domain.yMin) * height + 0.5);
+
+	std::atomic<uint32_t>* counter;
+	if (x >= 0.0 && x < width && y >= 0.0 && y < height)
+		counter = &hits[(size_t)y * width + (size_t)x];
+	else
+	{
+		x = std::floor((point.x + domain.threshold) / outerCellSize);
+		y = std::floor((point.y + domain.threshold) / outerCellSize);
+
+		// Can only happen through rounding, the set is inside the escape radius
+		if (x < 0.0 || x >= OuterGridSize || y < 0.0 || y >= OuterGridSize)
+			return false;
+
+		counter = &outerHits[(size_t)y * OuterGridSize + (size_t)x];
+	}
+
+	// Two threads can both get past the check, which only costs a few hits
+	if (counter->load(std::memory_order_relaxed) >= maxHits)
+		return false;
+
+	counter->fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void InverseIterationRenderer::Traverse(const Point& point, const JuliaDomain& domain, uint32_t maxDepth)
+{
+	if (point.depth >= maxDepth)
+		return;
+
+	std::vector<Point> stack;
+	PushPreimages(point, domain, stack);
+
+	uint64_t points = 0;
+	while (!stack.empty())
+	{
+		Point current = stack.back();
+		stack.pop_back();
+		points++;
+
+		if (Visit(current, domain) && current.depth < maxDepth)
+			PushPreimages(current, domain, stack);
+	}
+
+	pointCount += points;
+}
+
+void InverseIterationRenderer::PushPreimages(const Point& point, const JuliaDomain& domain, std::vector<Point>& points)
+{
+	std::complex<double> root = std::sqrt(std::complex<double>(point.x - domain.c[0], point.y - domain.c[1]));
+
+	points.push_back({ root.real(), root.imag(), point.depth + 1 });
+	points.push_back({ -root.real(), -root.imag(), point.depth + 1 });
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuEngine.hpp"
+
+// Modified inverse iteration method (MIIM). Instead of iterating every
+// pixel forward, points on the Julia set are pulled back through both
+// preimages +-sqrt(z - c), starting at the repelling fixed point. Backward
+// iteration is attracted to the set, so every point lands on it, and the
+// cost only depends on how many pixels the set covers. That makes it a fast
+// preview for disconnected and dust-like sets, where escape time spends
+// most of its iterations next to a set that hardly covers any pixels.
+//
+// The tree of preimages grows exponentially, so a point isn't followed
+// further once the pixel it lands on has been hit maxHits times. Points
+// outside the view are pruned the same way on a coarse grid covering the
+// whole set. The further the view is zoomed in, the more of the tree is cut
+// off outside of it, so this is meant for views of the whole set.
+//
+// The result has the layout of the other engines, but holds how many points
+// landed on each pixel instead of iteration counts, 0 for pixels away from
+// the set. The precision setting is ignored, everything is done in doubles.
+class InverseIterationRenderer : public CpuEngine
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	InverseIterationRenderer(uint32_t threadCount = 0);
+
+	void CalculateJuliaSet(const JuliaProperties& properties) override;
+	inline const char* GetName() const override { return "inverse-iteration"; }
+	inline std::string GetDescription() const override { return std::string(GetName()) + " " + std::to_string(maxHits); }
+
+	// Points are pulled back across the whole set and pruned per pixel, so
+	// the hits of a pixel depend on the rest of the view
+	inline bool IsTileLocal() const override { return false; }
+
+	// Hits after which a pixel stops points from being followed further
+	inline void SetMaxHits(uint32_t hits) { maxHits = hits; }
+
+	// How many points the last call pulled back
+	inline uint64_t GetPointCount() const { return pointCount; }
+
+private:
+	struct Point
+	{
+		double x, y;
+		uint32_t depth;
+	};
+
+	// Counts the hit of a point, returns false if it shouldn't be followed
+	bool Visit(const Point& point, const JuliaDomain& domain);
+
+	// Depth first through the preimages below point
+	void Traverse(const Point& point, const JuliaDomain& domain, uint32_t maxDepth);
+
+	static void PushPreimages(const Point& point, const JuliaDomain& domain, std::vector<Point>& points);
+
+private:
+	uint32_t maxHits;
+
+	std::vector<std::atomic<uint32_t>> hits;
+
+	// Hits outside of the view, on a grid covering the escape radius
+	std::vector<std::atomic<uint32_t>> outerHits;
+	double outerCellSize;
+
+	std::atomic<uint64_t> pointCount;
+};
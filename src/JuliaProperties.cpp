@@ -0,0 +1,185 @@
+#include "JuliaProperties.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool operator==(const JuliaProperties& a, const JuliaProperties& b)
+{
+	return
+		a.xBounds[0] == b.xBounds[0] && a.xBounds[1] == b.xBounds[1] &&
+		a.yCenter == b.yCenter &&
+		a.aspectRatio == b.aspectRatio &&
+		a.maxIterations == b.maxIterations &&
+		a.iterationColorCutoff == b.iterationColorCutoff &&
+		a.palette == b.palette &&
+		a.textureWidth == b.textureWidth &&
+		a.c[0] == b.c[0] && a.c[1] == b.c[1] &&
+		a.precision == b.precision &&
+		a.isPolar == b.isPolar &&
+		a.periodicityCheck == b.periodicityCheck;
+}
+
+bool HaveSameIterations(const JuliaProperties& a, const JuliaProperties& b)
+{
+	return
+		a.xBounds[0] == b.xBounds[0] && a.xBounds[1] == b.xBounds[1] &&
+		a.yCenter == b.yCenter &&
+		a.aspectRatio == b.aspectRatio &&
+		a.maxIterations == b.maxIterations &&
+		a.textureWidth == b.textureWidth &&
+		a.c[0] == b.c[0] && a.c[1] == b.c[1] &&
+		a.precision == b.precision &&
+		a.isPolar == b.isPolar &&
+		a.periodicityCheck == b.periodicityCheck;
+}
+
+JuliaDomain GetJuliaDomain(const JuliaProperties& properties)
+{
+	JuliaDomain domain;
+
+	// width and height of the target image
+	domain.width = properties.textureWidth;
+	domain.height = (uint32_t)(properties.textureWidth * properties.aspectRatio);
+
+	// domain in x direction
+	domain.xMin = properties.xBounds[0];
+	domain.xMax = properties.xBounds[1];
+
+	// domain in y direction
+	double yLength = (properties.xBounds[1] - properties.xBounds[0]) * properties.aspectRatio;
+	domain.yMin = properties.yCenter - 0.5 * yLength;
+	domain.yMax = properties.yCenter + 0.5 * yLength;
+
+	// c is either given in cartesian or polar coordinates
+	if (!properties.isPolar)
+	{
+		domain.c[0] = properties.c[0];
+		domain.c[1] = properties.c[1];
+	}
+	else
+	{
+		domain.c[0] = properties.c[0] * cosf(properties.c[1]);
+		domain.c[1] = properties.c[0] * sinf(properties.c[1]);
+	}
+
+	// Escape radius, same as in the compute shader
+	domain.threshold = 0.5 * (std::sqrt(4.0 * std::hypot(domain.c[0], domain.c[1]) + 1.0) + 1.0);
+
+	// The tolerance has to stay well below the size of a pixel, or points
+	// right next to the set would be taken for interior points. It also
+	// can't go below what the precision can resolve.
+	domain.periodicityTolerance = 0.0;
+	if (properties.periodicityCheck && domain.width > 0)
+	{
+		double pixelWidth = (domain.xMax - domain.xMin) / domain.width;
+		double precisionLimit = properties.precision != Precision::Single ? 1e-10 : 1e-5;
+		domain.periodicityTolerance = std::min(precisionLimit, 0.01 * pixelWidth);
+	}
+
+	return domain;
+}
+
+bool CanResumeIterations(const JuliaProperties& a, const JuliaProperties& b)
+{
+	JuliaProperties lowered = b;
+	lowered.maxIterations = a.maxIterations;
+
+	return b.maxIterations > a.maxIterations && HaveSameIterations(a, lowered);
+}
+
+bool GetPixelShift(const JuliaProperties& a, const JuliaProperties& b, int32_t& shiftX, int32_t& shiftY)
+{
+	// Everything but the position has to stay the same
+	if (a.aspectRatio != b.aspectRatio || a.textureWidth != b.textureWidth ||
+		a.maxIterations != b.maxIterations ||
+		a.c[0] != b.c[0] || a.c[1] != b.c[1] ||
+		a.precision != b.precision || a.isPolar != b.isPolar ||
+		a.periodicityCheck != b.periodicityCheck)
+	{
+		return false;
+	}
+
+	JuliaDomain from = GetJuliaDomain(a);
+	JuliaDomain to = GetJuliaDomain(b);
+	if (from.width == 0 || from.height == 0)
+		return false;
+
+	double pixelWidth = (from.xMax - from.xMin) / from.width;
+	double pixelHeight = (from.yMax - from.yMin) / from.height;
+
+	// Pixels are only reusable if they line up within a small fraction of a
+	// pixel, and the zoom level didn't change
+	const double tolerance = 0.01;
+	if (std::abs((to.xMax - to.xMin) - (from.xMax - from.xMin)) > tolerance * pixelWidth ||
+		std::abs((to.yMax - to.yMin) - (from.yMax - from.yMin)) > tolerance * pixelHeight)
+	{
+		return false;
+	}
+
+	double x = (to.xMin - from.xMin) / pixelWidth;
+	double y = (to.yMin - from.yMin) / pixelHeight;
+	if (std::abs(x - std::round(x)) > tolerance || std::abs(y - std::round(y)) > tolerance)
+		return false;
+
+	// Nothing is left to reuse if the view moved by more than its size
+	if (std::abs(x) >= from.width || std::abs(y) >= from.height)
+		return false;
+
+	shiftX = (int32_t)std::round(x);
+	shiftY = (int32_t)std::round(y);
+	return true;
+}
+
+JuliaDomain ShiftJuliaDomain(const JuliaDomain& domain, int32_t shiftX, int32_t shiftY)
+{
+	double pixelWidth = (domain.xMax - domain.xMin) / domain.width;
+	double pixelHeight = (domain.yMax - domain.yMin) / domain.height;
+
+	JuliaDomain shifted = domain;
+	shifted.xMin += shiftX * pixelWidth;
+	shifted.xMax += shiftX * pixelWidth;
+	shifted.yMin += shiftY * pixelHeight;
+	shifted.yMax += shiftY * pixelHeight;
+
+	return shifted;
+}
+
+bool GetMirrorSymmetry(const JuliaDomain& domain, int32_t& mirrorX, int32_t& mirrorY, Tile& mirrored)
+{
+	if (domain.width == 0 || domain.height == 0)
+		return false;
+
+	// Pixel x lies at xMin + x * pixelWidth, so its mirror image -(xMin + x * pixelWidth)
+	// lies on pixel -2 * xMin / pixelWidth - x. The same goes for y.
+	double pixelWidth = (domain.xMax - domain.xMin) / domain.width;
+	double pixelHeight = (domain.yMax - domain.yMin) / domain.height;
+	double x = -2.0 * domain.xMin / pixelWidth;
+	double y = -2.0 * domain.yMin / pixelHeight;
+
+	const double tolerance = 0.01;
+	if (std::abs(x - std::round(x)) > tolerance || std::abs(y - std::round(y)) > tolerance)
+		return false;
+
+	// Also rejects views that are too far away from the origin to overlap
+	// their own mirror image
+	if (std::abs(x) > 2.0 * domain.width || std::abs(y) > 2.0 * domain.height)
+		return false;
+
+	mirrorX = (int32_t)std::round(x);
+	mirrorY = (int32_t)std::round(y);
+
+	// Pixels whose mirror image is inside the image as well
+	int32_t left = std::max(0, mirrorX - (int32_t)domain.width + 1);
+	int32_t right = std::min((int32_t)domain.width - 1, mirrorX);
+	int32_t bottom = std::max(0, mirrorY - (int32_t)domain.height + 1);
+	int32_t top = std::min((int32_t)domain.height - 1, mirrorY);
+
+	// Of those, the rows above the center of symmetry are copied from the
+	// ones below it
+	bottom = std::max(bottom, mirrorY / 2 + 1);
+	if (left > right || bottom > top)
+		return false;
+
+	mirrored = { (uint32_t)left, (uint32_t)bottom, (uint32_t)(right - left + 1), (uint32_t)(top - bottom + 1) };
+	return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include "Tile.hpp"
+
+// Arithmetic the escape time loop is done in. DoubleFloat emulates doubles
+// with a pair of floats on GPUs where fp64 is slow, the CPU uses native
+// doubles for it.
+enum class Precision
+{
+	Single,
+	DoubleFloat,
+	Double
+};
+
+struct JuliaProperties
+{
+	// Double, so the view can be set at the resolution of the double and
+	// double-float shaders
+	double xBounds[2];
+	double yCenter;
+	float aspectRatio;
+	uint32_t maxIterations;
+	float iterationColorCutoff;
+	uint32_t palette;
+	uint32_t textureWidth;
+	float c[2];
+	Precision precision;
+	bool isPolar;
+	bool periodicityCheck;
+};
+
+bool operator==(const JuliaProperties& a, const JuliaProperties& b);
+inline bool operator!=(const JuliaProperties& a, const JuliaProperties& b) { return !(a == b); }
+
+// Whether both sets of properties produce the same iteration counts. Color
+// settings are applied when the counts are drawn and don't matter here.
+bool HaveSameIterations(const JuliaProperties& a, const JuliaProperties& b);
+
+// The image size and the region of the complex plane it covers, derived
+// from a set of JuliaProperties. Both the GPU and the CPU path use this so
+// they agree on how pixels map to points.
+struct JuliaDomain
+{
+	uint32_t width, height;
+	double xMin, xMax;
+	double yMin, yMax;
+	double c[2];
+	double threshold;
+
+	// How close an orbit has to come back to itself to count as caught in
+	// an attracting cycle, 0 if periodicity checking is off
+	double periodicityTolerance;
+};
+
+JuliaDomain GetJuliaDomain(const JuliaProperties& properties);
+
+// Returns true if b only differs from a by a higher maxIterations, so
+// iterating can continue from where a stopped
+bool CanResumeIterations(const JuliaProperties& a, const JuliaProperties& b);
+
+// Returns true if the view of b is the view of a moved by a whole number of
+// pixels, with everything else unchanged. The shift is returned in pixels.
+bool GetPixelShift(const JuliaProperties& a, const JuliaProperties& b, int32_t& shiftX, int32_t& shiftY);
+
+// Moves the domain by a whole number of its pixels
+JuliaDomain ShiftJuliaDomain(const JuliaDomain& domain, int32_t shiftX, int32_t shiftY);
+
+// The Julia sets of z^2 + c are symmetric under z -> -z, so pixel (x, y)
+// has the same iteration count as pixel (mirrorX - x, mirrorY - y). This
+// returns true if the pixel grid of the domain maps onto itself under that
+// symmetry, along with the region whose pixels can be copied from their
+// mirror image instead of being calculated.
+bool GetMirrorSymmetry(const JuliaDomain& domain, int32_t& mirrorX, int32_t& mirrorY, Tile& mirrored);
@@ -0,0 +1,128 @@
+#include "MarianiSilver.hpp"
+
+#include "EscapeTime.hpp"
+
+MarianiSilverRenderer::MarianiSilverRenderer(uint32_t threadCount) :
+	CpuEngine(threadCount), tileSize(128), minimumSize(4), skippedPixels(0)
+{
+}
+
+void MarianiSilverRenderer::CalculateJuliaSet(const JuliaProperties& properties)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+
+	width = domain.width;
+	height = domain.height;
+	iterations.assign((size_t)width * height, 0);
+	done.assign((size_t)width * height, 0);
+	skippedPixels = 0;
+
+	// Every top level rectangle is subdivided by a single worker, so the
+	// done flags of a tile are never touched by two threads
+	scheduler.Run(width, height, tileSize,
+		[&](const Tile& tile)
+		{
+			if (properties.precision != Precision::Single)
+				CalculateTile<double>(domain, properties.maxIterations, tile);
+			else
+				CalculateTile<float>(domain, properties.maxIterations, tile);
+		}
+	);
+}
+
+template<typename Real>
+void MarianiSilverRenderer::CalculateTile(const JuliaDomain& domain, uint32_t maxIterations, const Tile& tile)
+{
+	uint64_t skipped = 0;
+	Subdivide<Real>(domain, maxIterations, { tile.x, tile.y, tile.x + tile.width - 1, tile.y + tile.height - 1 }, skipped);
+
+	skippedPixels += skipped;
+}
+
+template<typename Real>
+void MarianiSilverRenderer::Subdivide(const JuliaDomain& domain, uint32_t maxIterations, const Rectangle& rectangle, uint64_t& skipped)
+{
+	uint32_t rectangleWidth = rectangle.right - rectangle.left + 1;
+	uint32_t rectangleHeight = rectangle.top - rectangle.bottom + 1;
+
+	// Small rectangles are cheaper to just calculate
+	if (rectangleWidth <= minimumSize || rectangleHeight <= minimumSize)
+	{
+		for (uint32_t y = rectangle.bottom; y <= rectangle.top; y++)
+		{
+			for (uint32_t x = rectangle.left; x <= rectangle.right; x++)
+				CalculatePixel<Real>(domain, maxIterations, x, y);
+		}
+
+		return;
+	}
+
+	// Walk along the border and check whether all counts are the same
+	uint32_t first = CalculatePixel<Real>(domain, maxIterations, rectangle.left, rectangle.bottom);
+	bool uniform = true;
+
+	for (uint32_t x = rectangle.left; x <= rectangle.right; x++)
+	{
+		uniform &= CalculatePixel<Real>(domain, maxIterations, x, rectangle.bottom) == first;
+		uniform &= CalculatePixel<Real>(domain, maxIterations, x, rectangle.top) == first;
+	}
+
+	for (uint32_t y = rectangle.bottom + 1; y < rectangle.top; y++)
+	{
+		uniform &= CalculatePixel<Real>(domain, maxIterations, rectangle.left, y) == first;
+		uniform &= CalculatePixel<Real>(domain, maxIterations, rectangle.right, y) == first;
+	}
+
+	if (uniform)
+	{
+		// Fill the inside without calculating it
+		for (uint32_t y = rectangle.bottom + 1; y < rectangle.top; y++)
+		{
+			for (uint32_t x = rectangle.left + 1; x < rectangle.right; x++)
+			{
+				size_t index = (size_t)y * width + x;
+				if (!done[index])
+				{
+					iterations[index] = first;
+					done[index] = 1;
+					skipped++;
+				}
+			}
+		}
+
+		return;
+	}
+
+	// Split along the longer side, both halves share the middle line
+	if (rectangleWidth >= rectangleHeight)
+	{
+		uint32_t middle = (rectangle.left + rectangle.right) / 2;
+		Subdivide<Real>(domain, maxIterations, { rectangle.left, rectangle.bottom, middle, rectangle.top }, skipped);
+		Subdivide<Real>(domain, maxIterations, { middle, rectangle.bottom, rectangle.right, rectangle.top }, skipped);
+	}
+	else
+	{
+		uint32_t middle = (rectangle.bottom + rectangle.top) / 2;
+		Subdivide<Real>(domain, maxIterations, { rectangle.left, rectangle.bottom, rectangle.right, middle }, skipped);
+		Subdivide<Real>(domain, maxIterations, { rectangle.left, middle, rectangle.right, rectangle.top }, skipped);
+	}
+}
+
+template<typename Real>
+uint32_t MarianiSilverRenderer::CalculatePixel(const JuliaDomain& domain, uint32_t maxIterations, uint32_t x, uint32_t y)
+{
+	size_t index = (size_t)y * width + x;
+	if (done[index])
+		return iterations[index];
+
+	// Pixel coordinates are mapped like in the escape time renderer
+	double dx = (domain.xMax - domain.xMin) / width;
+	Real zx = (Real)(domain.xMin + x * dx);
+	Real zy = (Real)(domain.yMin + y * (domain.yMax - domain.yMin) / height);
+
+	iterations[index] = EscapeTime<Real>(zx, zy, (Real)domain.c[0], (Real)domain.c[1], (Real)domain.threshold,
+		(Real)domain.periodicityTolerance, 0, maxIterations);
+	done[index] = 1;
+
+	return iterations[index];
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuEngine.hpp"
+
+// Mariani-Silver subdivision: only the border of a rectangle is calculated.
+// If every border pixel has the same iteration count, the inside is filled
+// with that count, otherwise the rectangle is split in two and each half is
+// handled the same way. Large uniform areas like interior basins or the far
+// exterior then cost little more than their outline.
+//
+// Filling assumes that nothing with a different count is enclosed by a
+// uniform border. Features that break that (small islands or filaments
+// thinner than a pixel that cross no border) are lost, so the result can
+// differ from the brute-force renderer. In practice that's well below 0.1%
+// of the pixels; rectangles at or below the minimum size are always
+// calculated in full.
+class MarianiSilverRenderer : public CpuEngine
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	MarianiSilverRenderer(uint32_t threadCount = 0);
+
+	void CalculateJuliaSet(const JuliaProperties& properties) override;
+	inline const char* GetName() const override { return "mariani-silver"; }
+	inline std::string GetDescription() const override { return std::string(GetName()) + " " + std::to_string(minimumSize); }
+
+	// Edge length of the top level rectangles handed to the worker threads
+	inline void SetTileSize(uint32_t size) { tileSize = size; }
+
+	// Rectangles with a side at or below this are calculated pixel by pixel
+	inline void SetMinimumSize(uint32_t size) { minimumSize = size; }
+
+	// How many pixels the last call filled in without calculating them
+	inline uint64_t GetSkippedPixels() const { return skippedPixels; }
+
+private:
+	// Inclusive pixel bounds
+	struct Rectangle
+	{
+		uint32_t left, bottom, right, top;
+	};
+
+	template<typename Real>
+	void CalculateTile(const JuliaDomain& domain, uint32_t maxIterations, const Tile& tile);
+
+	template<typename Real>
+	void Subdivide(const JuliaDomain& domain, uint32_t maxIterations, const Rectangle& rectangle, uint64_t& skipped);
+
+	template<typename Real>
+	uint32_t CalculatePixel(const JuliaDomain& domain, uint32_t maxIterations, uint32_t x, uint32_t y);
+
+private:
+	uint32_t tileSize;
+	uint32_t minimumSize;
+
+	// Which pixels were calculated (or filled) already, so shared borders
+	// aren't calculated twice
+	std::vector<uint8_t> done;
+	std::atomic<uint64_t> skippedPixels;
+};
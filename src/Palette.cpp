@@ -0,0 +1,46 @@
+#include "Palette.hpp"
+
+#include <algorithm>
+
+const std::vector<Palette>& GetPalettes()
+{
+	static const std::vector<Palette> palettes = {
+		// The original look, only red depends on the iteration count
+		{ "Classic", {
+			0.0f, 0.05f, 0.2f,
+			1.0f, 0.05f, 0.2f
+		} },
+		{ "Fire", {
+			0.0f, 0.0f, 0.0f,
+			0.5f, 0.0f, 0.0f,
+			1.0f, 0.35f, 0.0f,
+			1.0f, 0.85f, 0.2f,
+			1.0f, 1.0f, 1.0f
+		} },
+		{ "Ocean", {
+			0.0f, 0.02f, 0.1f,
+			0.0f, 0.2f, 0.45f,
+			0.0f, 0.55f, 0.75f,
+			0.9f, 1.0f, 1.0f
+		} },
+		{ "Grayscale", {
+			0.0f, 0.0f, 0.0f,
+			1.0f, 1.0f, 1.0f
+		} }
+	};
+
+	return palettes;
+}
+
+void SamplePalette(const Palette& palette, float t, float rgb[3])
+{
+	uint32_t size = palette.GetSize();
+	float position = std::min(std::max(t, 0.0f), 1.0f) * (size - 1);
+
+	uint32_t lower = std::min((uint32_t)position, size - 1);
+	uint32_t upper = std::min(lower + 1, size - 1);
+	float weight = position - lower;
+
+	for (int i = 0; i < 3; i++)
+		rgb[i] = palette.colors[3 * lower + i] * (1.0f - weight) + palette.colors[3 * upper + i] * weight;
+}
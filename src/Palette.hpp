@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A color gradient that iteration counts are mapped onto
+struct Palette
+{
+	std::string name;
+
+	// RGB triplets, evenly spaced from t = 0 to t = 1
+	std::vector<float> colors;
+
+	inline uint32_t GetSize() const { return (uint32_t)(colors.size() / 3); }
+};
+
+// All built in palettes, JuliaProperties::palette indexes into these
+const std::vector<Palette>& GetPalettes();
+
+// Linearly interpolates the palette at t, clamped to [0, 1]. This matches
+// what the render shader does with the palette texture.
+void SamplePalette(const Palette& palette, float t, float rgb[3]);
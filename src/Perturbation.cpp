@@ -0,0 +1,196 @@
+#include "Perturbation.hpp"
+
+#include <sstream>
+
+#include "EscapeTime.hpp"
+
+PerturbationRenderer::PerturbationRenderer(uint32_t threadCount) :
+	CpuEngine(threadCount), tileSize(64), maxReferences(64), hasView(false), viewWidth(0.0),
+	referenceCount(0), glitchedPixels(0)
+{
+}
+
+void PerturbationRenderer::SetView(const std::string& centerX, const std::string& centerY, double planeWidth)
+{
+	viewCenter[0] = centerX;
+	viewCenter[1] = centerY;
+	viewWidth = planeWidth;
+	hasView = true;
+}
+
+void PerturbationRenderer::ClearView()
+{
+	hasView = false;
+}
+
+std::string PerturbationRenderer::GetDescription() const
+{
+	std::ostringstream description;
+	description.precision(17);
+	description << GetName() << " " << maxReferences;
+	if (hasView)
+		description << " " << viewCenter[0] << " " << viewCenter[1] << " " << viewWidth;
+
+	return description.str();
+}
+
+void PerturbationRenderer::CalculateJuliaSet(const JuliaProperties& properties)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+	width = domain.width;
+	height = domain.height;
+
+	double pixelSize = hasView ? viewWidth / width : (domain.xMax - domain.xMin) / width;
+	uint32_t limbs = HighPrecision::LimbsForResolution(pixelSize);
+
+	HighPrecision centerX(limbs), centerY(limbs);
+	if (hasView)
+	{
+		centerX = HighPrecision::FromString(viewCenter[0], limbs);
+		centerY = HighPrecision::FromString(viewCenter[1], limbs);
+	}
+	else
+	{
+		centerX = HighPrecision(0.5 * (domain.xMin + domain.xMax), limbs);
+		centerY = HighPrecision(0.5 * (domain.yMin + domain.yMax), limbs);
+	}
+
+	// Pixels relative to the center are small enough for doubles
+	auto offsetX = [&](uint32_t x) { return (x - 0.5 * width) * pixelSize; };
+	auto offsetY = [&](uint32_t y) { return (y - 0.5 * height) * pixelSize; };
+
+	iterations.assign((size_t)width * height, 0);
+	pending.assign((size_t)width * height, 1);
+	referenceCount = 0;
+
+	// The first reference sits in the middle of the image
+	uint32_t referenceX = width / 2, referenceY = height / 2;
+	while (true)
+	{
+		ReferenceOrbit orbit = CalculateReferenceOrbit(
+			centerX + HighPrecision(offsetX(referenceX), limbs),
+			centerY + HighPrecision(offsetY(referenceY), limbs),
+			domain, properties.maxIterations
+		);
+		referenceCount++;
+
+		double baseX = offsetX(referenceX), baseY = offsetY(referenceY);
+		glitchedPixels = 0;
+
+		scheduler.Run(width, height, tileSize,
+			[&](const Tile& tile)
+			{
+				uint64_t glitched = 0;
+				for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+				{
+					for (uint32_t x = tile.x; x < tile.x + tile.width; x++)
+					{
+						size_t index = (size_t)y * width + x;
+						if (!pending[index])
+							continue;
+
+						if (CalculatePixel(orbit, offsetX(x) - baseX, offsetY(y) - baseY, domain, properties.maxIterations, iterations[index]))
+							pending[index] = 0;
+						else
+							glitched++;
+					}
+				}
+
+				glitchedPixels += glitched;
+			}
+		);
+
+		if (glitchedPixels == 0 || referenceCount >= maxReferences)
+			break;
+
+		// The glitched pixel that got furthest before glitching becomes the
+		// next reference, its orbit is likely useful for most of the others
+		size_t best = 0;
+		uint32_t bestIterations = 0;
+		bool found = false;
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			if (pending[i] && (!found || iterations[i] > bestIterations))
+			{
+				best = i;
+				bestIterations = iterations[i];
+				found = true;
+			}
+		}
+
+		referenceX = (uint32_t)(best % width);
+		referenceY = (uint32_t)(best / width);
+	}
+}
+
+PerturbationRenderer::ReferenceOrbit PerturbationRenderer::CalculateReferenceOrbit(const HighPrecision& x, const HighPrecision& y, const JuliaDomain& domain, uint32_t maxIterations)
+{
+	uint32_t limbs = x.GetFractionLimbs();
+	HighPrecision cx(domain.c[0], limbs), cy(domain.c[1], limbs);
+	HighPrecision zx = x, zy = y;
+
+	double thresholdSquared = domain.threshold * domain.threshold;
+
+	ReferenceOrbit orbit;
+	for (uint32_t i = 0; i < maxIterations; i++)
+	{
+		double px = zx.ToDouble(), py = zy.ToDouble();
+		double radius = px * px + py * py;
+
+		orbit.x.push_back(px);
+		orbit.y.push_back(py);
+		orbit.glitchRadius.push_back(radius * 1e-6);
+
+		// The escaped value is still stored, pixels check against it
+		if (radius > thresholdSquared)
+			break;
+
+		HighPrecision xx = zx * zx;
+		HighPrecision yy = zy * zy;
+		HighPrecision xy = zx * zy;
+
+		zx = xx - yy + cx;
+		zy = xy + xy + cy;
+	}
+
+	return orbit;
+}
+
+bool PerturbationRenderer::CalculatePixel(const ReferenceOrbit& orbit, double dx, double dy, const JuliaDomain& domain, uint32_t maxIterations, uint32_t& iterations)
+{
+	double thresholdSquared = domain.threshold * domain.threshold;
+	uint32_t orbitLength = (uint32_t)orbit.x.size();
+
+	for (uint32_t i = 0; i < maxIterations; i++)
+	{
+		// The reference escaped before this pixel did
+		if (i >= orbitLength)
+		{
+			iterations = i;
+			return false;
+		}
+
+		double zx = orbit.x[i] + dx;
+		double zy = orbit.y[i] + dy;
+		double radius = zx * zx + zy * zy;
+
+		if (radius > thresholdSquared)
+		{
+			iterations = i;
+			return true;
+		}
+
+		if (radius < orbit.glitchRadius[i])
+		{
+			iterations = i;
+			return false;
+		}
+
+		double x = 2.0 * (orbit.x[i] * dx - orbit.y[i] * dy) + dx * dx - dy * dy;
+		dy = 2.0 * (orbit.x[i] * dy + orbit.y[i] * dx) + 2.0 * dx * dy;
+		dx = x;
+	}
+
+	iterations = InteriorIterations;
+	return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "CpuEngine.hpp"
+#include "HighPrecision.hpp"
+
+// Deep zoom renderer. One reference orbit Z_n is calculated in high
+// precision, every pixel only tracks its difference d_n = z_n - Z_n, which
+// follows d_n+1 = 2 Z_n d_n + d_n^2 and fits into a double no matter how
+// deep the zoom is. That works down to a view width of around 1e-290,
+// where the differences start to underflow.
+//
+// Where the reference orbit is a bad approximation the pixel loses all its
+// precision ("glitch"). Those pixels are detected with Pauldelbrot's
+// criterion |Z_n + d_n| < 1e-3 |Z_n|, or when the reference escapes before
+// the pixel does, and are calculated again with a new reference orbit
+// picked from among them.
+class PerturbationRenderer : public CpuEngine
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	PerturbationRenderer(uint32_t threadCount = 0);
+
+	// Without a view, the bounds in the properties are used. Otherwise the
+	// view is centered on the given decimal coordinates and planeWidth wide,
+	// and only c, the iteration count and the image size are taken from the
+	// properties.
+	void SetView(const std::string& centerX, const std::string& centerY, double planeWidth);
+	void ClearView();
+
+	void CalculateJuliaSet(const JuliaProperties& properties) override;
+	inline const char* GetName() const override { return "perturbation"; }
+	std::string GetDescription() const override;
+
+	// With a view of its own, the bounds of the properties are ignored
+	inline bool IsTileLocal() const override { return !hasView; }
+
+	inline void SetTileSize(uint32_t size) { tileSize = size; }
+
+	// Upper limit for the number of reference orbits of one image
+	inline void SetMaxReferences(uint32_t count) { maxReferences = count; }
+
+	// Reference orbits used by the last call, and how many pixels were
+	// still glitched when the limit was reached. Those keep the count at
+	// which the glitch was detected.
+	inline uint32_t GetReferenceCount() const { return referenceCount; }
+	inline uint64_t GetGlitchedPixels() const { return glitchedPixels; }
+
+private:
+	struct ReferenceOrbit
+	{
+		std::vector<double> x, y;
+
+		// |Z_n|^2 * 1e-6, below that a pixel is glitched
+		std::vector<double> glitchRadius;
+	};
+
+	static ReferenceOrbit CalculateReferenceOrbit(const HighPrecision& x, const HighPrecision& y, const JuliaDomain& domain, uint32_t maxIterations);
+
+	// Returns false if the pixel glitched, iterations is set either way
+	static bool CalculatePixel(const ReferenceOrbit& orbit, double dx, double dy, const JuliaDomain& domain, uint32_t maxIterations, uint32_t& iterations);
+
+private:
+	uint32_t tileSize;
+	uint32_t maxReferences;
+
+	bool hasView;
+	std::string viewCenter[2];
+	double viewWidth;
+
+	// Pixels that still have to be calculated with the next reference
+	std::vector<uint8_t> pending;
+	uint32_t referenceCount;
+	std::atomic<uint64_t> glitchedPixels;
+};
@@ -0,0 +1,152 @@
+#include "ProgramCache.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+static const char Magic[8] = { 'J', 'U', 'L', 'I', 'A', 'P', 'R', 'G' };
+
+static uint64_t HashSource(const std::string& source)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : source)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+template<typename T>
+static bool ReadValue(std::istream& file, T& value)
+{
+	return (bool)file.read((char*)&value, sizeof(value));
+}
+
+template<typename T>
+static void WriteValue(std::ostream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(value));
+}
+
+ProgramCache::ProgramCache(const std::string& path, const std::string& driver) :
+	path(path), driver(driver), modified(false)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return;
+
+	// Sizes in the file are checked against what's left of it, a corrupt or
+	// foreign file must not make us allocate gigabytes
+	uint64_t remaining = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	// Layout: magic, driver string, then entries of key, format, size and
+	// binary. The file is written in one go, a truncated one is dropped.
+	char magic[8];
+	uint32_t driverLength;
+	if (!file.read(magic, 8) || !std::equal(magic, magic + 8, Magic) || !ReadValue(file, driverLength) || driverLength != driver.size())
+		return;
+
+	std::string fileDriver(driverLength, '\0');
+	if (!file.read(&fileDriver[0], driverLength) || fileDriver != driver)
+		return;
+
+	remaining -= sizeof(magic) + sizeof(driverLength) + driverLength;
+
+	uint64_t key;
+	while (ReadValue(file, key))
+	{
+		Entry entry;
+		uint32_t size;
+		uint64_t headerSize = sizeof(key) + sizeof(entry.format) + sizeof(size);
+		if (!ReadValue(file, entry.format) || !ReadValue(file, size) || size > remaining - std::min(remaining, headerSize))
+		{
+			// Nothing of a broken file is trusted, it's replaced on the next save
+			entries.clear();
+			modified = true;
+			return;
+		}
+
+		entry.binary.resize(size);
+		if (!file.read((char*)entry.binary.data(), size))
+		{
+			entries.clear();
+			modified = true;
+			return;
+		}
+
+		remaining -= headerSize + size;
+		entries[key] = std::move(entry);
+	}
+}
+
+std::unique_ptr<Shader> ProgramCache::CreateComputeProgram(const std::string& source)
+{
+	uint64_t key = HashSource(source);
+	requested.insert(key);
+
+	// Drivers may still reject binaries they wrote, e.g. after a change of
+	// hardware they don't include in their version string
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		std::unique_ptr<Shader> program = std::make_unique<Shader>();
+		if (program->LoadBinary(it->second.format, it->second.binary))
+			return program;
+
+		entries.erase(it);
+		modified = true;
+	}
+
+	std::unique_ptr<Shader> program = std::make_unique<Shader>();
+	program->AttachComputeShader(source);
+	program->Link();
+
+	// Drivers without binary formats just compile every time
+	Entry entry;
+	if (program->GetBinary(entry.format, entry.binary))
+	{
+		entries[key] = std::move(entry);
+		modified = true;
+	}
+
+	return program;
+}
+
+void ProgramCache::Save()
+{
+	// Programs nobody asked for since the last save are dropped
+	for (auto it = entries.begin(); it != entries.end(); )
+	{
+		if (requested.count(it->first) == 0)
+		{
+			it = entries.erase(it);
+			modified = true;
+		}
+		else
+			++it;
+	}
+
+	requested.clear();
+	if (!modified)
+		return;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return;
+
+	file.write(Magic, 8);
+	WriteValue(file, (uint32_t)driver.size());
+	file.write(driver.data(), driver.size());
+
+	for (const auto& [key, entry] : entries)
+	{
+		WriteValue(file, key);
+		WriteValue(file, entry.format);
+		WriteValue(file, (uint32_t)entry.binary.size());
+		file.write((const char*)entry.binary.data(), entry.binary.size());
+	}
+
+	modified = !file;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Shader.hpp"
+
+// Keeps linked compute programs in a file as driver specific binaries
+// (glGetProgramBinary), so they don't have to be compiled on every start.
+// Entries are keyed by a hash of the source. The file also records the
+// driver it was written by, and is started over when that changes or the
+// file doesn't look like one of ours.
+class ProgramCache
+{
+public:
+	// Reads the whole file, if there is one. driver identifies GPU and
+	// driver version.
+	ProgramCache(const std::string& path, const std::string& driver);
+
+	// A linked program for the source, loaded from the cache if the driver
+	// accepts the binary, otherwise compiled and added to the cache
+	std::unique_ptr<Shader> CreateComputeProgram(const std::string& source);
+
+	// Writes the programs requested since the last call to the file, the
+	// others (e.g. of an old work group size) are dropped from it
+	void Save();
+
+private:
+	struct Entry
+	{
+		uint32_t format;
+		std::vector<uint8_t> binary;
+	};
+
+	std::string path;
+	std::string driver;
+	std::unordered_map<uint64_t, Entry> entries;
+	std::unordered_set<uint64_t> requested;
+	bool modified;
+};
@@ -91,6 +91,8 @@ void Shader::Link()
 	GLint result;
 	char infoLog[512];
 
+	// Allows GetBinary() later on
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program);
 	glGetProgramiv(program, GL_LINK_STATUS, &result);
 	if (!result)
@@ -111,6 +113,36 @@ void Shader::Link()
 		glDeleteShader(computeShader);
 }
 
+bool Shader::LoadBinary(uint32_t format, const std::vector<uint8_t>& binary)
+{
+	GLint result;
+	glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+	glGetProgramiv(program, GL_LINK_STATUS, &result);
+
+	return result;
+}
+
+bool Shader::GetBinary(uint32_t& format, std::vector<uint8_t>& binary)
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount == 0)
+		return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	GLenum binaryFormat;
+	binary.resize(length);
+	glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+	binary.resize(length);
+	format = binaryFormat;
+
+	return length > 0;
+}
+
 void Shader::Use()
 {
 	glUseProgram(program);
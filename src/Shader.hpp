@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 class Shader
 {
@@ -13,6 +15,14 @@ public:
 	void AttachComputeShader(const std::string& computeSource);
 	void Link();
 
+	// Uses a program binary from GetBinary() instead of compiling and
+	// linking. Returns false if the driver doesn't accept it anymore.
+	bool LoadBinary(uint32_t format, const std::vector<uint8_t>& binary);
+
+	// The binary of the linked program, false if the driver has no binary
+	// formats
+	bool GetBinary(uint32_t& format, std::vector<uint8_t>& binary);
+
 	void Use();
 
 private:
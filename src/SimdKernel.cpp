@@ -0,0 +1,152 @@
+#include "SimdKernel.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "EscapeTime.hpp"
+
+#ifdef JULIA_X86_KERNELS
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#include <immintrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+template<typename Real>
+static void EscapeTimeRowScalar(const KernelRow& row, uint32_t count, uint32_t* out)
+{
+	Real startY = (Real)row.y;
+	Real cx = (Real)row.c[0];
+	Real cy = (Real)row.c[1];
+	Real threshold = (Real)row.threshold;
+	Real periodicityTolerance = (Real)row.periodicityTolerance;
+
+	for (uint32_t k = 0; k < count; k++)
+	{
+		Real zx = (Real)(row.x0 + k * row.dx);
+		Real zy = startY;
+		uint32_t firstIteration = 0;
+
+		if (row.resume)
+		{
+			// Pixels that escaped already keep their count
+			if (out[k] != InteriorIterations)
+				continue;
+
+			zx = (Real)row.zx[k];
+			zy = (Real)row.zy[k];
+			firstIteration = row.firstIteration;
+		}
+
+		out[k] = EscapeTime<Real>(zx, zy, cx, cy, threshold, periodicityTolerance, firstIteration, row.maxIterations);
+
+		if (row.zx && out[k] == InteriorIterations)
+		{
+			row.zx[k] = zx;
+			row.zy[k] = zy;
+		}
+	}
+}
+
+#ifdef JULIA_X86_KERNELS
+static void CpuId(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#ifdef _MSC_VER
+	int result[4];
+	__cpuidex(result, (int)leaf, (int)subleaf);
+	for (int i = 0; i < 4; i++)
+		registers[i] = (uint32_t)result[i];
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// Which register states the OS saves on context switches
+static uint64_t GetEnabledStates()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+InstructionSet DetectInstructionSet()
+{
+	static const InstructionSet detected = []()
+	{
+#ifdef JULIA_X86_KERNELS
+		uint32_t registers[4];
+		CpuId(0, 0, registers);
+		uint32_t maxLeaf = registers[0];
+		if (maxLeaf < 7)
+			return InstructionSet::Scalar;
+
+		// The OS has to support AVX through XSAVE before we can check anything else
+		CpuId(1, 0, registers);
+		bool osxsave = registers[2] & (1u << 27);
+		bool avx = registers[2] & (1u << 28);
+		if (!osxsave || !avx)
+			return InstructionSet::Scalar;
+
+		uint64_t states = GetEnabledStates();
+		bool ymmEnabled = (states & 0x06) == 0x06;
+		bool zmmEnabled = (states & 0xE6) == 0xE6;
+
+		CpuId(7, 0, registers);
+		bool avx2 = registers[1] & (1u << 5);
+		bool avx512f = registers[1] & (1u << 16);
+
+		if (avx512f && zmmEnabled)
+			return InstructionSet::AVX512;
+
+		if (avx2 && ymmEnabled)
+			return InstructionSet::AVX2;
+#endif
+		return InstructionSet::Scalar;
+	}();
+
+	return detected;
+}
+
+bool IsInstructionSetSupported(InstructionSet isa)
+{
+	return (int)isa <= (int)DetectInstructionSet();
+}
+
+const char* GetInstructionSetName(InstructionSet isa)
+{
+	switch (isa)
+	{
+	case InstructionSet::Scalar:	return "scalar";
+	case InstructionSet::AVX2:		return "avx2";
+	case InstructionSet::AVX512:	return "avx512";
+	}
+
+	return "unknown";
+}
+
+RowKernel GetRowKernel(InstructionSet isa, bool doublePrecision)
+{
+	if (!IsInstructionSetSupported(isa))
+		throw std::runtime_error("Instruction set " + std::string(GetInstructionSetName(isa)) + " is not supported on this CPU");
+
+	switch (isa)
+	{
+#ifdef JULIA_X86_KERNELS
+	case InstructionSet::AVX2:
+		return doublePrecision ? EscapeTimeRowAVX2Double : EscapeTimeRowAVX2Float;
+
+	case InstructionSet::AVX512:
+		return doublePrecision ? EscapeTimeRowAVX512Double : EscapeTimeRowAVX512Float;
+#endif
+
+	default:
+		return doublePrecision ? EscapeTimeRowScalar<double> : EscapeTimeRowScalar<float>;
+	}
+}
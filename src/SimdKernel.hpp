@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+// One row of pixels to run the escape-time iteration on. Pixel k of the row
+// starts at z = (x0 + k * dx) + y * i.
+struct KernelRow
+{
+	double x0, dx;
+	double y;
+	double c[2];
+	double threshold;
+	uint32_t maxIterations;
+
+	// Points whose orbit comes back this close to an earlier point are
+	// caught in an attracting cycle and classified as interior right away.
+	// 0 turns cycle detection off.
+	double periodicityTolerance;
+
+	// Optional per pixel z. If set, the kernel stores the last z of every
+	// pixel that didn't escape in here.
+	double* zx;
+	double* zy;
+
+	// Continue where an earlier call with firstIteration as maxIterations
+	// stopped: z starts at (zx[k], zy[k]) instead of the pixel position, and
+	// only pixels whose count in out is InteriorIterations are iterated.
+	bool resume;
+	uint32_t firstIteration;
+};
+
+// Writes the iteration count of count pixels to out
+using RowKernel = void(*)(const KernelRow& row, uint32_t count, uint32_t* out);
+
+enum class InstructionSet
+{
+	Scalar,
+	AVX2,
+	AVX512
+};
+
+// The widest instruction set supported by both the CPU and the OS
+InstructionSet DetectInstructionSet();
+bool IsInstructionSetSupported(InstructionSet isa);
+const char* GetInstructionSetName(InstructionSet isa);
+
+// Returns the row kernel for the given instruction set and precision.
+// Throws if the instruction set isn't supported on this machine.
+RowKernel GetRowKernel(InstructionSet isa, bool doublePrecision);
+
+// Vectorized kernels, each lives in its own translation unit so it can be
+// compiled for its instruction set without affecting the rest of the code
+#ifdef JULIA_X86_KERNELS
+void EscapeTimeRowAVX2Float(const KernelRow& row, uint32_t count, uint32_t* out);
+void EscapeTimeRowAVX2Double(const KernelRow& row, uint32_t count, uint32_t* out);
+void EscapeTimeRowAVX512Float(const KernelRow& row, uint32_t count, uint32_t* out);
+void EscapeTimeRowAVX512Double(const KernelRow& row, uint32_t count, uint32_t* out);
+#endif
@@ -0,0 +1,219 @@
+#include "SimdKernel.hpp"
+
+#include <immintrin.h>
+
+#include "EscapeTime.hpp"
+
+// This file is compiled with AVX2 enabled, it must only be called after
+// DetectInstructionSet() confirmed the CPU supports it. Don't call any
+// inline functions shared with other translation units from here.
+
+void EscapeTimeRowAVX2Float(const KernelRow& row, uint32_t count, uint32_t* out)
+{
+	const __m256 cx = _mm256_set1_ps((float)row.c[0]);
+	const __m256 cy = _mm256_set1_ps((float)row.c[1]);
+	const float threshold = (float)row.threshold;
+	const __m256 thresholdSquared = _mm256_set1_ps(threshold * threshold);
+	const float tolerance = (float)row.periodicityTolerance;
+	const __m256 toleranceSquared = _mm256_set1_ps(tolerance * tolerance);
+	const bool periodicity = row.periodicityTolerance > 0.0;
+
+	alignas(32) float startX[8], startY[8];
+	alignas(32) uint32_t result[8];
+	alignas(32) uint32_t startActive[8];
+
+	for (uint32_t first = 0; first < count; first += 8)
+	{
+		uint32_t lanes = count - first < 8 ? count - first : 8;
+		uint32_t firstIteration = 0;
+
+		for (uint32_t k = 0; k < 8; k++)
+		{
+			startX[k] = (float)(row.x0 + (first + k) * row.dx);
+			startY[k] = (float)row.y;
+			result[k] = InteriorIterations;
+			startActive[k] = 0xFFFFFFFF;
+		}
+
+		// Continue from the stored z, pixels that escaped already stay inactive
+		if (row.resume)
+		{
+			firstIteration = row.firstIteration;
+			for (uint32_t k = 0; k < 8; k++)
+			{
+				bool interior = k < lanes && out[first + k] == InteriorIterations;
+				result[k] = k < lanes ? out[first + k] : 0;
+				startActive[k] = interior ? 0xFFFFFFFF : 0;
+				startX[k] = interior ? (float)row.zx[first + k] : 0.0f;
+				startY[k] = interior ? (float)row.zy[first + k] : 0.0f;
+			}
+		}
+
+		__m256 zx = _mm256_load_ps(startX);
+		__m256 zy = _mm256_load_ps(startY);
+
+		__m256i iterations = _mm256_load_si256((const __m256i*)result);
+		__m256 active = _mm256_load_ps((const float*)startActive);
+
+		// Brent's cycle detection, see EscapeTime()
+		__m256 savedX = zx, savedY = zy;
+		uint32_t saveInterval = 1, sinceSave = 0;
+
+		for (uint32_t i = firstIteration; i < row.maxIterations && !_mm256_testz_ps(active, active); i++)
+		{
+			__m256 x2 = _mm256_mul_ps(zx, zx);
+			__m256 y2 = _mm256_mul_ps(zy, zy);
+
+			// Lanes that escape in this iteration
+			__m256 escaped = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(x2, y2), thresholdSquared, _CMP_GT_OQ), active);
+			if (!_mm256_testz_ps(escaped, escaped))
+			{
+				iterations = _mm256_blendv_epi8(iterations, _mm256_set1_epi32((int)i), _mm256_castps_si256(escaped));
+				active = _mm256_andnot_ps(escaped, active);
+
+				// Stop as soon as every lane escaped
+				if (_mm256_testz_ps(active, active))
+					break;
+			}
+
+			zy = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(zx, zx), zy), cy);
+			zx = _mm256_add_ps(_mm256_sub_ps(x2, y2), cx);
+
+			if (periodicity)
+			{
+				// Lanes caught in an attracting cycle are interior points
+				__m256 dx = _mm256_sub_ps(zx, savedX);
+				__m256 dy = _mm256_sub_ps(zy, savedY);
+				__m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+				active = _mm256_andnot_ps(_mm256_cmp_ps(distance, toleranceSquared, _CMP_LT_OQ), active);
+
+				if (++sinceSave == saveInterval)
+				{
+					savedX = zx;
+					savedY = zy;
+					sinceSave = 0;
+					saveInterval *= 2;
+				}
+			}
+		}
+
+		_mm256_store_si256((__m256i*)result, iterations);
+		_mm256_store_ps(startX, zx);
+		_mm256_store_ps(startY, zy);
+
+		for (uint32_t k = 0; k < lanes; k++)
+		{
+			out[first + k] = result[k];
+
+			if (row.zx && result[k] == InteriorIterations)
+			{
+				row.zx[first + k] = startX[k];
+				row.zy[first + k] = startY[k];
+			}
+		}
+	}
+}
+
+void EscapeTimeRowAVX2Double(const KernelRow& row, uint32_t count, uint32_t* out)
+{
+	const __m256d cx = _mm256_set1_pd(row.c[0]);
+	const __m256d cy = _mm256_set1_pd(row.c[1]);
+	const __m256d thresholdSquared = _mm256_set1_pd(row.threshold * row.threshold);
+	const __m256d toleranceSquared = _mm256_set1_pd(row.periodicityTolerance * row.periodicityTolerance);
+	const bool periodicity = row.periodicityTolerance > 0.0;
+
+	alignas(32) double startX[4], startY[4];
+	alignas(32) uint64_t result[4];
+	alignas(32) uint64_t startActive[4];
+
+	for (uint32_t first = 0; first < count; first += 4)
+	{
+		uint32_t lanes = count - first < 4 ? count - first : 4;
+		uint32_t firstIteration = 0;
+
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			startX[k] = row.x0 + (first + k) * row.dx;
+			startY[k] = row.y;
+			result[k] = InteriorIterations;
+			startActive[k] = ~0ull;
+		}
+
+		// Continue from the stored z, pixels that escaped already stay inactive
+		if (row.resume)
+		{
+			firstIteration = row.firstIteration;
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				bool interior = k < lanes && out[first + k] == InteriorIterations;
+				result[k] = k < lanes ? out[first + k] : 0;
+				startActive[k] = interior ? ~0ull : 0;
+				startX[k] = interior ? row.zx[first + k] : 0.0;
+				startY[k] = interior ? row.zy[first + k] : 0.0;
+			}
+		}
+
+		__m256d zx = _mm256_load_pd(startX);
+		__m256d zy = _mm256_load_pd(startY);
+
+		__m256i iterations = _mm256_load_si256((const __m256i*)result);
+		__m256d active = _mm256_load_pd((const double*)startActive);
+
+		// Brent's cycle detection, see EscapeTime()
+		__m256d savedX = zx, savedY = zy;
+		uint32_t saveInterval = 1, sinceSave = 0;
+
+		for (uint32_t i = firstIteration; i < row.maxIterations && !_mm256_testz_pd(active, active); i++)
+		{
+			__m256d x2 = _mm256_mul_pd(zx, zx);
+			__m256d y2 = _mm256_mul_pd(zy, zy);
+
+			// Lanes that escape in this iteration
+			__m256d escaped = _mm256_and_pd(_mm256_cmp_pd(_mm256_add_pd(x2, y2), thresholdSquared, _CMP_GT_OQ), active);
+			if (!_mm256_testz_pd(escaped, escaped))
+			{
+				iterations = _mm256_blendv_epi8(iterations, _mm256_set1_epi64x(i), _mm256_castpd_si256(escaped));
+				active = _mm256_andnot_pd(escaped, active);
+
+				// Stop as soon as every lane escaped
+				if (_mm256_testz_pd(active, active))
+					break;
+			}
+
+			zy = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(zx, zx), zy), cy);
+			zx = _mm256_add_pd(_mm256_sub_pd(x2, y2), cx);
+
+			if (periodicity)
+			{
+				// Lanes caught in an attracting cycle are interior points
+				__m256d dx = _mm256_sub_pd(zx, savedX);
+				__m256d dy = _mm256_sub_pd(zy, savedY);
+				__m256d distance = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+				active = _mm256_andnot_pd(_mm256_cmp_pd(distance, toleranceSquared, _CMP_LT_OQ), active);
+
+				if (++sinceSave == saveInterval)
+				{
+					savedX = zx;
+					savedY = zy;
+					sinceSave = 0;
+					saveInterval *= 2;
+				}
+			}
+		}
+
+		_mm256_store_si256((__m256i*)result, iterations);
+		_mm256_store_pd(startX, zx);
+		_mm256_store_pd(startY, zy);
+
+		for (uint32_t k = 0; k < lanes; k++)
+		{
+			out[first + k] = (uint32_t)result[k];
+
+			if (row.zx && out[first + k] == InteriorIterations)
+			{
+				row.zx[first + k] = startX[k];
+				row.zy[first + k] = startY[k];
+			}
+		}
+	}
+}
@@ -0,0 +1,220 @@
+#include "SimdKernel.hpp"
+
+#include <immintrin.h>
+
+#include "EscapeTime.hpp"
+
+// This file is compiled with AVX-512 enabled, it must only be called after
+// DetectInstructionSet() confirmed the CPU supports it. Don't call any
+// inline functions shared with other translation units from here.
+
+void EscapeTimeRowAVX512Float(const KernelRow& row, uint32_t count, uint32_t* out)
+{
+	const __m512 cx = _mm512_set1_ps((float)row.c[0]);
+	const __m512 cy = _mm512_set1_ps((float)row.c[1]);
+	const float threshold = (float)row.threshold;
+	const __m512 thresholdSquared = _mm512_set1_ps(threshold * threshold);
+	const float tolerance = (float)row.periodicityTolerance;
+	const __m512 toleranceSquared = _mm512_set1_ps(tolerance * tolerance);
+	const bool periodicity = row.periodicityTolerance > 0.0;
+
+	alignas(64) float startX[16], startY[16];
+	alignas(64) uint32_t result[16];
+
+	for (uint32_t first = 0; first < count; first += 16)
+	{
+		uint32_t lanes = count - first < 16 ? count - first : 16;
+		uint32_t firstIteration = 0;
+		__mmask16 active = 0xFFFF;
+
+		for (uint32_t k = 0; k < 16; k++)
+		{
+			startX[k] = (float)(row.x0 + (first + k) * row.dx);
+			startY[k] = (float)row.y;
+			result[k] = InteriorIterations;
+		}
+
+		// Continue from the stored z, pixels that escaped already stay inactive
+		if (row.resume)
+		{
+			firstIteration = row.firstIteration;
+			active = 0;
+			for (uint32_t k = 0; k < 16; k++)
+			{
+				bool interior = k < lanes && out[first + k] == InteriorIterations;
+				result[k] = k < lanes ? out[first + k] : 0;
+				active |= interior ? (__mmask16)(1u << k) : 0;
+				startX[k] = interior ? (float)row.zx[first + k] : 0.0f;
+				startY[k] = interior ? (float)row.zy[first + k] : 0.0f;
+			}
+		}
+
+		__m512 zx = _mm512_load_ps(startX);
+		__m512 zy = _mm512_load_ps(startY);
+
+		__m512i iterations = _mm512_load_si512((const void*)result);
+
+		// Brent's cycle detection, see EscapeTime()
+		__m512 savedX = zx, savedY = zy;
+		uint32_t saveInterval = 1, sinceSave = 0;
+
+		for (uint32_t i = firstIteration; i < row.maxIterations && active; i++)
+		{
+			__m512 x2 = _mm512_mul_ps(zx, zx);
+			__m512 y2 = _mm512_mul_ps(zy, zy);
+
+			// Lanes that escape in this iteration
+			__mmask16 escaped = _mm512_mask_cmp_ps_mask(active, _mm512_add_ps(x2, y2), thresholdSquared, _CMP_GT_OQ);
+			if (escaped)
+			{
+				iterations = _mm512_mask_mov_epi32(iterations, escaped, _mm512_set1_epi32((int)i));
+				active &= ~escaped;
+
+				// Stop as soon as every lane escaped
+				if (!active)
+					break;
+			}
+
+			zy = _mm512_add_ps(_mm512_mul_ps(_mm512_add_ps(zx, zx), zy), cy);
+			zx = _mm512_add_ps(_mm512_sub_ps(x2, y2), cx);
+
+			if (periodicity)
+			{
+				// Lanes caught in an attracting cycle are interior points
+				__m512 dx = _mm512_sub_ps(zx, savedX);
+				__m512 dy = _mm512_sub_ps(zy, savedY);
+				__m512 distance = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+				active &= ~_mm512_mask_cmp_ps_mask(active, distance, toleranceSquared, _CMP_LT_OQ);
+
+				if (++sinceSave == saveInterval)
+				{
+					savedX = zx;
+					savedY = zy;
+					sinceSave = 0;
+					saveInterval *= 2;
+				}
+			}
+		}
+
+		_mm512_store_si512((void*)result, iterations);
+		_mm512_store_ps(startX, zx);
+		_mm512_store_ps(startY, zy);
+
+		for (uint32_t k = 0; k < lanes; k++)
+		{
+			out[first + k] = result[k];
+
+			if (row.zx && result[k] == InteriorIterations)
+			{
+				row.zx[first + k] = startX[k];
+				row.zy[first + k] = startY[k];
+			}
+		}
+	}
+}
+
+void EscapeTimeRowAVX512Double(const KernelRow& row, uint32_t count, uint32_t* out)
+{
+	const __m512d cx = _mm512_set1_pd(row.c[0]);
+	const __m512d cy = _mm512_set1_pd(row.c[1]);
+	const __m512d thresholdSquared = _mm512_set1_pd(row.threshold * row.threshold);
+	const __m512d toleranceSquared = _mm512_set1_pd(row.periodicityTolerance * row.periodicityTolerance);
+	const bool periodicity = row.periodicityTolerance > 0.0;
+
+	alignas(64) double startX[8], startY[8];
+	alignas(64) uint32_t result[16];
+
+	for (uint32_t first = 0; first < count; first += 8)
+	{
+		uint32_t lanes = count - first < 8 ? count - first : 8;
+		uint32_t firstIteration = 0;
+		__mmask8 active = 0xFF;
+
+		// Only the lower 8 lanes of the counts are used, one per double lane
+		for (uint32_t k = 0; k < 16; k++)
+			result[k] = InteriorIterations;
+
+		for (uint32_t k = 0; k < 8; k++)
+		{
+			startX[k] = row.x0 + (first + k) * row.dx;
+			startY[k] = row.y;
+		}
+
+		// Continue from the stored z, pixels that escaped already stay inactive
+		if (row.resume)
+		{
+			firstIteration = row.firstIteration;
+			active = 0;
+			for (uint32_t k = 0; k < 8; k++)
+			{
+				bool interior = k < lanes && out[first + k] == InteriorIterations;
+				result[k] = k < lanes ? out[first + k] : 0;
+				active |= interior ? (__mmask8)(1u << k) : 0;
+				startX[k] = interior ? row.zx[first + k] : 0.0;
+				startY[k] = interior ? row.zy[first + k] : 0.0;
+			}
+		}
+
+		__m512d zx = _mm512_load_pd(startX);
+		__m512d zy = _mm512_load_pd(startY);
+
+		__m512i iterations = _mm512_load_si512((const void*)result);
+
+		// Brent's cycle detection, see EscapeTime()
+		__m512d savedX = zx, savedY = zy;
+		uint32_t saveInterval = 1, sinceSave = 0;
+
+		for (uint32_t i = firstIteration; i < row.maxIterations && active; i++)
+		{
+			__m512d x2 = _mm512_mul_pd(zx, zx);
+			__m512d y2 = _mm512_mul_pd(zy, zy);
+
+			// Lanes that escape in this iteration
+			__mmask8 escaped = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(x2, y2), thresholdSquared, _CMP_GT_OQ);
+			if (escaped)
+			{
+				iterations = _mm512_mask_mov_epi32(iterations, (__mmask16)escaped, _mm512_set1_epi32((int)i));
+				active &= ~escaped;
+
+				// Stop as soon as every lane escaped
+				if (!active)
+					break;
+			}
+
+			zy = _mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(zx, zx), zy), cy);
+			zx = _mm512_add_pd(_mm512_sub_pd(x2, y2), cx);
+
+			if (periodicity)
+			{
+				// Lanes caught in an attracting cycle are interior points
+				__m512d dx = _mm512_sub_pd(zx, savedX);
+				__m512d dy = _mm512_sub_pd(zy, savedY);
+				__m512d distance = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+				active &= ~_mm512_mask_cmp_pd_mask(active, distance, toleranceSquared, _CMP_LT_OQ);
+
+				if (++sinceSave == saveInterval)
+				{
+					savedX = zx;
+					savedY = zy;
+					sinceSave = 0;
+					saveInterval *= 2;
+				}
+			}
+		}
+
+		_mm512_store_si512((void*)result, iterations);
+		_mm512_store_pd(startX, zx);
+		_mm512_store_pd(startY, zy);
+
+		for (uint32_t k = 0; k < lanes; k++)
+		{
+			out[first + k] = result[k];
+
+			if (row.zx && result[k] == InteriorIterations)
+			{
+				row.zx[first + k] = startX[k];
+				row.zy[first + k] = startY[k];
+			}
+		}
+	}
+}
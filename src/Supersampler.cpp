@@ -0,0 +1,198 @@
+#include "Supersampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "EscapeTime.hpp"
+#include "Image.hpp"
+
+static constexpr uint32_t TileSize = 64;
+
+// Jitter that only depends on the pixel and the sample, so the same image
+// comes out on every run and with any number of threads
+static double Jitter(uint32_t x, uint32_t y, uint32_t sample)
+{
+	uint64_t value = ((uint64_t)x << 40) ^ ((uint64_t)y << 16) ^ sample;
+	value ^= value >> 33;
+	value *= 0xFF51AFD7ED558CCDull;
+	value ^= value >> 33;
+	value *= 0xC4CEB9FE1A85EC53ull;
+	value ^= value >> 33;
+
+	return (double)(value >> 11) / (double)(1ull << 53);
+}
+
+BoundarySupersampler::BoundarySupersampler(uint32_t threadCount) :
+	scheduler(threadCount), instructionSet(DetectInstructionSet()), maxSamples(16), contrastThreshold(0.1f),
+	refinedPixels(0), sampleCount(0)
+{
+}
+
+void BoundarySupersampler::SetInstructionSet(InstructionSet isa)
+{
+	if (!IsInstructionSetSupported(isa))
+		throw std::runtime_error(std::string("Instruction set ") + GetInstructionSetName(isa) + " isn't supported on this machine");
+
+	instructionSet = isa;
+}
+
+void BoundarySupersampler::Supersample(const JuliaProperties& properties, const std::vector<uint32_t>& iterations, std::vector<uint8_t>& rgb)
+{
+	JuliaDomain domain = GetJuliaDomain(properties);
+	if (iterations.size() != (size_t)domain.width * domain.height || rgb.size() != iterations.size() * 3)
+		throw std::runtime_error("Supersampling needs an image of the size given by the properties");
+
+	refinedPixels = 0;
+	sampleCount = 0;
+	if (maxSamples < 4)
+		return;
+
+	// Edges are found on the unrefined image, so the result doesn't depend
+	// on the order the tiles are processed in
+	std::vector<uint8_t> original = rgb;
+
+	scheduler.Run(domain.width, domain.height, TileSize,
+		[&](const Tile& tile)
+		{
+			SupersampleTile(properties, domain, tile, original, rgb);
+		}
+	);
+}
+
+bool BoundarySupersampler::IsEdge(const std::vector<uint8_t>& rgb, uint32_t width, uint32_t height, uint32_t x, uint32_t y) const
+{
+	int threshold = (int)(contrastThreshold * 255.0f);
+	const uint8_t* pixel = &rgb[((size_t)y * width + x) * 3];
+
+	for (uint32_t ny = (y > 0 ? y - 1 : y); ny <= y + 1 && ny < height; ny++)
+	{
+		for (uint32_t nx = (x > 0 ? x - 1 : x); nx <= x + 1 && nx < width; nx++)
+		{
+			const uint8_t* neighbour = &rgb[((size_t)ny * width + nx) * 3];
+			for (int i = 0; i < 3; i++)
+			{
+				if (std::abs((int)pixel[i] - (int)neighbour[i]) > threshold)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void BoundarySupersampler::SupersampleTile(const JuliaProperties& properties, const JuliaDomain& domain, const Tile& tile,
+	const std::vector<uint8_t>& original, std::vector<uint8_t>& rgb)
+{
+	struct EdgePixel
+	{
+		uint32_t x, y;
+		float sum[3];
+		float color[3];
+	};
+
+	std::vector<EdgePixel> pixels;
+	for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+	{
+		for (uint32_t x = tile.x; x < tile.x + tile.width; x++)
+		{
+			if (IsEdge(original, domain.width, domain.height, x, y))
+				pixels.push_back({ x, y, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } });
+		}
+	}
+
+	if (pixels.empty())
+		return;
+
+	double dx = (domain.xMax - domain.xMin) / domain.width;
+	double dy = (domain.yMax - domain.yMin) / domain.height;
+
+	// Every sample gets its own starting z, which makes the kernel iterate
+	// arbitrary points instead of a row
+	KernelRow row = {};
+	row.c[0] = domain.c[0];
+	row.c[1] = domain.c[1];
+	row.threshold = domain.threshold;
+	row.maxIterations = properties.maxIterations;
+	row.periodicityTolerance = domain.periodicityTolerance;
+	row.resume = true;
+	row.firstIteration = 0;
+
+	RowKernel kernel = GetRowKernel(instructionSet, properties.precision != Precision::Single);
+
+	// Pixels that still take samples
+	std::vector<uint32_t> active(pixels.size());
+	for (uint32_t i = 0; i < active.size(); i++)
+		active[i] = i;
+
+	std::vector<double> zx, zy;
+	std::vector<uint32_t> counts;
+	uint64_t samples = 0;
+
+	for (uint32_t batch = 0; batch * 4 + 4 <= maxSamples && !active.empty(); batch++)
+	{
+		zx.resize(active.size() * 4);
+		zy.resize(active.size() * 4);
+		counts.assign(active.size() * 4, InteriorIterations);
+
+		// The engines sample the point xMin + x * dx, which is taken as the
+		// center of the pixel here. One jittered sample per quadrant.
+		for (size_t i = 0; i < active.size(); i++)
+		{
+			const EdgePixel& pixel = pixels[active[i]];
+			for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+			{
+				uint32_t sample = batch * 4 + quadrant;
+				double offsetX = 0.5 * ((quadrant & 1) + Jitter(pixel.x, pixel.y, 2 * sample)) - 0.5;
+				double offsetY = 0.5 * ((quadrant >> 1) + Jitter(pixel.x, pixel.y, 2 * sample + 1)) - 0.5;
+
+				zx[i * 4 + quadrant] = domain.xMin + (pixel.x + offsetX) * dx;
+				zy[i * 4 + quadrant] = domain.yMin + (pixel.y + offsetY) * dy;
+			}
+		}
+
+		row.zx = zx.data();
+		row.zy = zy.data();
+		kernel(row, (uint32_t)counts.size(), counts.data());
+		samples += counts.size();
+
+		// Stop once another batch hardly moved the average
+		size_t remaining = 0;
+		for (size_t i = 0; i < active.size(); i++)
+		{
+			EdgePixel& pixel = pixels[active[i]];
+			for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+			{
+				float color[3];
+				ColorizeIteration(properties, counts[i * 4 + quadrant], color);
+				for (int k = 0; k < 3; k++)
+					pixel.sum[k] += color[k];
+			}
+
+			float change = 0.0f;
+			for (int k = 0; k < 3; k++)
+			{
+				float average = pixel.sum[k] / ((batch + 1) * 4);
+				change = std::max(change, std::abs(average - pixel.color[k]));
+				pixel.color[k] = average;
+			}
+
+			if (batch == 0 || change >= contrastThreshold * 0.25f)
+				active[remaining++] = active[i];
+		}
+
+		active.resize(remaining);
+	}
+
+	for (const EdgePixel& pixel : pixels)
+	{
+		uint8_t* out = &rgb[((size_t)pixel.y * domain.width + pixel.x) * 3];
+		for (int k = 0; k < 3; k++)
+			out[k] = (uint8_t)(std::min(std::max(pixel.color[k], 0.0f), 1.0f) * 255.0f + 0.5f);
+	}
+
+	refinedPixels += pixels.size();
+	sampleCount += samples;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "JuliaProperties.hpp"
+#include "SimdKernel.hpp"
+#include "TileScheduler.hpp"
+
+// Antialiasing as a second pass over a colored image. Only pixels whose
+// color differs strongly from one of their eight neighbours get more
+// samples, which in practice are the pixels along the boundary of the set.
+// Smooth regions inside and outside of it keep their single sample, so the
+// cost stays a fraction of rendering the whole image at a higher
+// resolution.
+//
+// Neighbours are compared by color, not by iteration count. Differences in
+// the counts above the cutoff of the palette don't show, and comparing or
+// averaging counts would blend across the cutoff into colors that appear
+// nowhere in the image.
+//
+// Samples are added in batches of four, one jittered sample per quadrant of
+// the pixel, until another batch hardly changes the average or the sample
+// limit is reached. The pixel gets the average color of its samples.
+class BoundarySupersampler
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	BoundarySupersampler(uint32_t threadCount = 0);
+
+	// Defaults to the widest instruction set the CPU supports
+	void SetInstructionSet(InstructionSet isa);
+
+	// Upper limit of samples per pixel, rounded down to a multiple of 4
+	inline void SetMaxSamples(uint32_t samples) { maxSamples = samples; }
+
+	// Largest difference of a color channel (0 to 1) to a neighbour that
+	// still counts as smooth
+	inline void SetContrastThreshold(float threshold) { contrastThreshold = threshold; }
+
+	// Refines rgb, the colored iterations of properties, in place. The
+	// counts have to come from an escape time engine working on the domain
+	// of the properties.
+	void Supersample(const JuliaProperties& properties, const std::vector<uint32_t>& iterations, std::vector<uint8_t>& rgb);
+
+	// Pixels the last call took more samples of, and how many in total
+	inline uint64_t GetRefinedPixels() const { return refinedPixels; }
+	inline uint64_t GetSampleCount() const { return sampleCount; }
+	inline uint32_t GetThreadCount() const { return scheduler.GetThreadCount(); }
+
+private:
+	bool IsEdge(const std::vector<uint8_t>& rgb, uint32_t width, uint32_t height, uint32_t x, uint32_t y) const;
+
+	// Refines the edge pixels of one tile, the samples of all of them go
+	// through the row kernel together
+	void SupersampleTile(const JuliaProperties& properties, const JuliaDomain& domain, const Tile& tile,
+		const std::vector<uint8_t>& original, std::vector<uint8_t>& rgb);
+
+private:
+	TileScheduler scheduler;
+	InstructionSet instructionSet;
+	uint32_t maxSamples;
+	float contrastThreshold;
+
+	std::atomic<uint64_t> refinedPixels;
+	std::atomic<uint64_t> sampleCount;
+};
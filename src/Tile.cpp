@@ -0,0 +1,70 @@
+#include "Tile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+std::vector<Tile> GetExposedStrips(uint32_t width, uint32_t height, int32_t shiftX, int32_t shiftY)
+{
+	std::vector<Tile> strips;
+
+	uint32_t columns = std::min((uint32_t)std::abs(shiftX), width);
+	uint32_t rows = std::min((uint32_t)std::abs(shiftY), height);
+
+	// Columns that scrolled into view, over the full height
+	if (columns > 0)
+		strips.push_back({ shiftX > 0 ? width - columns : 0, 0, columns, height });
+
+	// Rows that scrolled into view, minus the part the columns already cover
+	if (rows > 0 && columns < width)
+		strips.push_back({ shiftX > 0 ? 0 : columns, shiftY > 0 ? height - rows : 0, width - columns, rows });
+
+	return strips;
+}
+
+std::vector<Tile> SubtractTile(const Tile& region, const Tile& hole)
+{
+	std::vector<Tile> tiles;
+
+	// Clip the hole to the region
+	uint32_t left = std::max(region.x, hole.x);
+	uint32_t right = std::min(region.x + region.width, hole.x + hole.width);
+	uint32_t bottom = std::max(region.y, hole.y);
+	uint32_t top = std::min(region.y + region.height, hole.y + hole.height);
+
+	if (left >= right || bottom >= top)
+	{
+		tiles.push_back(region);
+		return tiles;
+	}
+
+	// Full width bands below and above the hole
+	if (bottom > region.y)
+		tiles.push_back({ region.x, region.y, region.width, bottom - region.y });
+
+	if (top < region.y + region.height)
+		tiles.push_back({ region.x, top, region.width, region.y + region.height - top });
+
+	// Left and right of the hole, between the bands
+	if (left > region.x)
+		tiles.push_back({ region.x, bottom, left - region.x, top - bottom });
+
+	if (right < region.x + region.width)
+		tiles.push_back({ right, bottom, region.x + region.width - right, top - bottom });
+
+	return tiles;
+}
+
+std::vector<Tile> SplitIntoTiles(const Tile& region, uint32_t tileSize)
+{
+	std::vector<Tile> tiles;
+	if (tileSize == 0)
+		tileSize = 1;
+
+	for (uint32_t y = 0; y < region.height; y += tileSize)
+	{
+		for (uint32_t x = 0; x < region.width; x += tileSize)
+			tiles.push_back({ region.x + x, region.y + y, std::min(tileSize, region.width - x), std::min(tileSize, region.height - y) });
+	}
+
+	return tiles;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A rectangle of pixels
+struct Tile
+{
+	uint32_t x, y;
+	uint32_t width, height;
+};
+
+// After the image was panned by (shiftX, shiftY) pixels, returns the strips
+// along the edges that have no valid pixels yet. A positive shift means the
+// view moved towards larger coordinates.
+std::vector<Tile> GetExposedStrips(uint32_t width, uint32_t height, int32_t shiftX, int32_t shiftY);
+
+// Splits the part of region that lies outside of hole into up to four tiles
+std::vector<Tile> SubtractTile(const Tile& region, const Tile& hole);
+
+// Splits region into tiles of at most tileSize x tileSize pixels, row by row
+std::vector<Tile> SplitIntoTiles(const Tile& region, uint32_t tileSize);
@@ -0,0 +1,333 @@
+#include "TileCache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Pixel sizes are rounded to 40 bits of mantissa, so views that only
+// differ by rounding errors (zooming in and back out) land on the same grid
+static const int DroppedMantissaBits = 12;
+
+// The rounding moves global pixel g by up to g * 2^-41 pixels, which stays
+// below 1/200 of a pixel up to here
+static const double MaxGridOrigin = 1e10;
+
+// The grid is shifted against the origin in steps of 1/PhaseSteps pixels
+static const int64_t PhaseSteps = 64;
+
+static const uint64_t SlotMagic = 0x31454843414354ull; // "TCACHE1"
+static const uint64_t SlotHeaderSize = 32;
+static const uint64_t SlotSize = SlotHeaderSize + (uint64_t)CacheTileSize * CacheTileSize * sizeof(uint32_t);
+
+static double RoundPixelSize(double size)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &size, sizeof(bits));
+	bits = (bits + (1ull << (DroppedMantissaBits - 1))) & ~((1ull << DroppedMantissaBits) - 1);
+	std::memcpy(&size, &bits, sizeof(size));
+
+	return size;
+}
+
+static void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+// Splits a position in pixels into a whole pixel and a quantized fraction
+static void SplitPosition(double position, int64_t& origin, int64_t& phase)
+{
+	origin = (int64_t)std::floor(position);
+	phase = (int64_t)std::llround((position - (double)origin) * PhaseSteps);
+	if (phase == PhaseSteps)
+	{
+		origin++;
+		phase = 0;
+	}
+}
+
+bool GetTileGrid(const JuliaProperties& properties, const JuliaDomain& domain, const std::string& source, TileGrid& grid)
+{
+	if (domain.width == 0 || domain.height == 0)
+		return false;
+
+	grid.pixelWidth = RoundPixelSize((domain.xMax - domain.xMin) / domain.width);
+	grid.pixelHeight = RoundPixelSize((domain.yMax - domain.yMin) / domain.height);
+	if (!(grid.pixelWidth > 0.0) || !(grid.pixelHeight > 0.0))
+		return false;
+
+	// The tiles are calculated with the aspect ratio of a pixel, which has
+	// to give a height of exactly one tile
+	float aspectRatio = (float)(grid.pixelHeight / grid.pixelWidth);
+	while ((uint32_t)(CacheTileSize * aspectRatio) < CacheTileSize)
+		aspectRatio = std::nextafter(aspectRatio, 2.0f * aspectRatio);
+	if ((uint32_t)(CacheTileSize * aspectRatio) != CacheTileSize)
+		return false;
+
+	double x = domain.xMin / grid.pixelWidth;
+	double y = domain.yMin / grid.pixelHeight;
+	if (!(std::abs(x) < MaxGridOrigin) || !(std::abs(y) < MaxGridOrigin))
+		return false;
+
+	int64_t phaseX, phaseY;
+	SplitPosition(x, grid.originX, phaseX);
+	SplitPosition(y, grid.originY, phaseY);
+	grid.phaseX = (double)phaseX / PhaseSteps;
+	grid.phaseY = (double)phaseY / PhaseSteps;
+
+	// Everything else that changes the counts. The bounds and the image size
+	// don't, they only decide which tiles are needed.
+	uint64_t hash = 14695981039346656037ull;
+	uint32_t precision = (uint32_t)properties.precision;
+	uint32_t periodicityCheck = properties.periodicityCheck ? 1 : 0;
+	HashBytes(hash, domain.c, sizeof(domain.c));
+	HashBytes(hash, &precision, sizeof(precision));
+	HashBytes(hash, &properties.maxIterations, sizeof(properties.maxIterations));
+	HashBytes(hash, &periodicityCheck, sizeof(periodicityCheck));
+	HashBytes(hash, &grid.pixelWidth, sizeof(grid.pixelWidth));
+	HashBytes(hash, &grid.pixelHeight, sizeof(grid.pixelHeight));
+	HashBytes(hash, &phaseX, sizeof(phaseX));
+	HashBytes(hash, &phaseY, sizeof(phaseY));
+	HashBytes(hash, source.data(), source.size());
+	grid.parameters = hash;
+
+	return true;
+}
+
+JuliaProperties GetCacheTileProperties(const JuliaProperties& properties, const TileGrid& grid, int64_t tileX, int64_t tileY)
+{
+	double left = (double)(tileX * CacheTileSize) + grid.phaseX;
+	double bottom = (double)(tileY * CacheTileSize) + grid.phaseY;
+
+	JuliaProperties tile = properties;
+	tile.textureWidth = CacheTileSize;
+	tile.xBounds[0] = left * grid.pixelWidth;
+	tile.xBounds[1] = (left + CacheTileSize) * grid.pixelWidth;
+	tile.yCenter = (bottom + 0.5 * CacheTileSize) * grid.pixelHeight;
+
+	// Same as in GetTileGrid(), which made sure this ends at the tile height
+	tile.aspectRatio = (float)(grid.pixelHeight / grid.pixelWidth);
+	while ((uint32_t)(CacheTileSize * tile.aspectRatio) < CacheTileSize)
+		tile.aspectRatio = std::nextafter(tile.aspectRatio, 2.0f * tile.aspectRatio);
+
+	return tile;
+}
+
+size_t TileKeyHash::operator()(const TileKey& key) const
+{
+	uint64_t hash = key.parameters;
+	HashBytes(hash, &key.x, sizeof(key.x));
+	HashBytes(hash, &key.y, sizeof(key.y));
+
+	return (size_t)hash;
+}
+
+TileCache::TileCache(size_t memoryTiles, const std::string& diskPath, uint32_t diskSlots) :
+	memoryTiles(memoryTiles), disk(nullptr), diskSize(0), diskSlots(0), stats{}
+{
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = nullptr;
+#else
+	fileDescriptor = -1;
+#endif
+
+	if (diskPath.empty() || diskSlots == 0)
+		return;
+
+	uint64_t size = (uint64_t)diskSlots * SlotSize;
+
+	// The file is created at its full size, empty slots read as zeros and
+	// don't have the magic number. Most file systems don't allocate them
+	// until they're written to.
+#ifdef _WIN32
+	fileHandle = CreateFileA(diskPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Failed to open tile cache " + diskPath);
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || (uint64_t)fileSize.QuadPart != size)
+	{
+		fileSize.QuadPart = (LONGLONG)size;
+		if (!SetFilePointerEx(fileHandle, fileSize, nullptr, FILE_BEGIN) || !SetEndOfFile(fileHandle))
+		{
+			CloseHandle(fileHandle);
+			throw std::runtime_error("Failed to resize tile cache " + diskPath);
+		}
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, nullptr);
+	if (mappingHandle != nullptr)
+		disk = (uint8_t*)MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+
+	if (disk == nullptr)
+	{
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		throw std::runtime_error("Failed to map tile cache " + diskPath);
+	}
+#else
+	fileDescriptor = open(diskPath.c_str(), O_RDWR | O_CREAT, 0644);
+	if (fileDescriptor < 0)
+		throw std::runtime_error("Failed to open tile cache " + diskPath);
+
+	// A cache with a different number of slots is thrown away, its tiles
+	// would be in the wrong slots
+	off_t fileSize = lseek(fileDescriptor, 0, SEEK_END);
+	if ((uint64_t)fileSize != size && (ftruncate(fileDescriptor, 0) != 0 || ftruncate(fileDescriptor, (off_t)size) != 0))
+	{
+		close(fileDescriptor);
+		throw std::runtime_error("Failed to resize tile cache " + diskPath);
+	}
+
+	void* mapping = mmap(nullptr, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close(fileDescriptor);
+		throw std::runtime_error("Failed to map tile cache " + diskPath);
+	}
+
+	disk = (uint8_t*)mapping;
+#endif
+
+	diskSize = size;
+	this->diskSlots = diskSlots;
+}
+
+TileCache::~TileCache()
+{
+	if (disk == nullptr)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(disk);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+#else
+	munmap(disk, (size_t)diskSize);
+	close(fileDescriptor);
+#endif
+}
+
+bool TileCache::Find(const TileKey& key, std::vector<uint32_t>& iterations)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = index.find(key);
+	if (it != index.end())
+	{
+		lru.splice(lru.begin(), lru, it->second);
+		iterations = it->second->second;
+		stats.memoryHits++;
+		return true;
+	}
+
+	if (FindOnDisk(key, iterations))
+	{
+		StoreInMemory(key, iterations);
+		stats.diskHits++;
+		return true;
+	}
+
+	stats.misses++;
+	return false;
+}
+
+void TileCache::Store(const TileKey& key, const std::vector<uint32_t>& iterations)
+{
+	if (iterations.size() != (size_t)CacheTileSize * CacheTileSize)
+		throw std::runtime_error("Cached tiles have to be CacheTileSize pixels square");
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	StoreInMemory(key, iterations);
+	StoreOnDisk(key, iterations);
+}
+
+TileCacheStats TileCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+void TileCache::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats = {};
+}
+
+void TileCache::StoreInMemory(const TileKey& key, const std::vector<uint32_t>& iterations)
+{
+	if (memoryTiles == 0)
+		return;
+
+	auto it = index.find(key);
+	if (it != index.end())
+	{
+		it->second->second = iterations;
+		lru.splice(lru.begin(), lru, it->second);
+		return;
+	}
+
+	// Reuse the buffer of the least recently used tile
+	if (lru.size() >= memoryTiles)
+	{
+		index.erase(lru.back().first);
+		lru.splice(lru.begin(), lru, std::prev(lru.end()));
+		lru.front().first = key;
+		lru.front().second = iterations;
+	}
+	else
+		lru.emplace_front(key, iterations);
+
+	index[key] = lru.begin();
+}
+
+bool TileCache::FindOnDisk(const TileKey& key, std::vector<uint32_t>& iterations)
+{
+	if (disk == nullptr)
+		return false;
+
+	const uint8_t* slot = disk + (TileKeyHash()(key) % diskSlots) * SlotSize;
+
+	uint64_t header[4];
+	std::memcpy(header, slot, sizeof(header));
+	if (header[0] != SlotMagic || header[1] != key.parameters || header[2] != (uint64_t)key.x || header[3] != (uint64_t)key.y)
+		return false;
+
+	iterations.resize((size_t)CacheTileSize * CacheTileSize);
+	std::memcpy(iterations.data(), slot + SlotHeaderSize, iterations.size() * sizeof(uint32_t));
+	return true;
+}
+
+void TileCache::StoreOnDisk(const TileKey& key, const std::vector<uint32_t>& iterations)
+{
+	if (disk == nullptr)
+		return;
+
+	uint8_t* slot = disk + (TileKeyHash()(key) % diskSlots) * SlotSize;
+
+	// The magic number goes in last, so a slot that was only half written
+	// when the program died doesn't count as a tile
+	uint64_t header[4] = { 0, key.parameters, (uint64_t)key.x, (uint64_t)key.y };
+	std::memcpy(slot, header, sizeof(header));
+	std::memcpy(slot + SlotHeaderSize, iterations.data(), iterations.size() * sizeof(uint32_t));
+	std::memcpy(slot, &SlotMagic, sizeof(SlotMagic));
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "JuliaProperties.hpp"
+
+// Iteration counts are cached in square tiles on a grid that only depends on
+// the pixel size, so a view that comes back later (zooming back out, a
+// bookmark, panning back and forth) finds the tiles it calculated before no
+// matter where exactly its edges are.
+constexpr uint32_t CacheTileSize = 256;
+
+// Where the pixels of a view sit on the global grid of its zoom level. Pixel
+// (x, y) of the view is global pixel (originX + x, originY + y), which lies
+// at ((originX + x + phaseX) * pixelWidth, (originY + y + phaseY) * pixelHeight).
+struct TileGrid
+{
+	// Hash of everything besides the position that affects the counts
+	uint64_t parameters;
+
+	double pixelWidth, pixelHeight;
+	int64_t originX, originY;
+	double phaseX, phaseY;
+};
+
+// Returns false if the view can't be put on a grid reliably, e.g. zoomed in
+// so far that the rounding of the pixel size would shift pixels visibly.
+// The source separates results of calculations that can differ slightly,
+// like the GPU and CPU paths.
+bool GetTileGrid(const JuliaProperties& properties, const JuliaDomain& domain, const std::string& source, TileGrid& grid);
+
+struct TileKey
+{
+	uint64_t parameters;
+	int64_t x, y;
+
+	inline bool operator==(const TileKey& other) const { return parameters == other.parameters && x == other.x && y == other.y; }
+};
+
+struct TileKeyHash
+{
+	size_t operator()(const TileKey& key) const;
+};
+
+// Properties that calculate exactly the given tile of the grid
+JuliaProperties GetCacheTileProperties(const JuliaProperties& properties, const TileGrid& grid, int64_t tileX, int64_t tileY);
+
+struct TileCacheStats
+{
+	uint64_t memoryHits, diskHits, misses;
+};
+
+// Two tiers: the most recently used tiles in memory, and a larger file
+// that's mapped into memory. The file is a direct mapped cache, every key
+// has one slot, and a new tile simply replaces whatever was there. Tiles
+// that are found on disk move into memory.
+// All functions can be called from several threads.
+class TileCache
+{
+public:
+	// An empty path or zero slots leave out the disk tier
+	TileCache(size_t memoryTiles, const std::string& diskPath = "", uint32_t diskSlots = 0);
+	~TileCache();
+
+	TileCache(const TileCache&) = delete;
+	TileCache& operator=(const TileCache&) = delete;
+
+	// Copies the tile's CacheTileSize^2 counts into iterations, rows start
+	// at the bottom
+	bool Find(const TileKey& key, std::vector<uint32_t>& iterations);
+	void Store(const TileKey& key, const std::vector<uint32_t>& iterations);
+
+	TileCacheStats GetStats();
+	void ResetStats();
+
+private:
+	void StoreInMemory(const TileKey& key, const std::vector<uint32_t>& iterations);
+	bool FindOnDisk(const TileKey& key, std::vector<uint32_t>& iterations);
+	void StoreOnDisk(const TileKey& key, const std::vector<uint32_t>& iterations);
+
+private:
+	std::mutex mutex;
+
+	// Most recently used at the front
+	size_t memoryTiles;
+	std::list<std::pair<TileKey, std::vector<uint32_t>>> lru;
+	std::unordered_map<TileKey, decltype(lru)::iterator, TileKeyHash> index;
+
+	// Memory mapped file of diskSlots slots
+	uint8_t* disk;
+	uint64_t diskSize;
+	uint32_t diskSlots;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+
+	TileCacheStats stats;
+};
@@ -0,0 +1,188 @@
+#include "TileScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+static double Milliseconds(Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+TileScheduler::TileScheduler(uint32_t threadCount) :
+	generation(0), finishedWorkers(0), shutdown(false), work(nullptr), failed(false)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+
+	// hardware_concurrency() may return 0 if it can't tell
+	if (threadCount == 0)
+		threadCount = 1;
+
+	stats.wallMilliseconds = 0.0;
+	stats.workers.resize(threadCount, WorkerStats{ 0, 0, 0.0, 0.0 });
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		queues.push_back(std::make_unique<WorkerQueue>());
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		workers.emplace_back(&TileScheduler::WorkerLoop, this, i);
+}
+
+TileScheduler::~TileScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shutdown = true;
+	}
+	runStarted.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void TileScheduler::Run(uint32_t width, uint32_t height, uint32_t tileSize, const std::function<void(const Tile&)>& work)
+{
+	Run(std::vector<Tile>{ { 0, 0, width, height } }, tileSize, work);
+}
+
+void TileScheduler::Run(const std::vector<Tile>& regions, uint32_t tileSize, const std::function<void(const Tile&)>& work)
+{
+	if (tileSize == 0)
+		tileSize = 1;
+
+	// Split the regions into tiles, row by row
+	std::vector<Tile> tiles;
+	for (const Tile& region : regions)
+	{
+		std::vector<Tile> regionTiles = SplitIntoTiles(region, tileSize);
+		tiles.insert(tiles.end(), regionTiles.begin(), regionTiles.end());
+	}
+
+	// Every worker starts out with a contiguous block, that way neighbouring
+	// tiles (which likely cost about the same) end up on the same thread
+	uint32_t threadCount = GetThreadCount();
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		size_t first = tiles.size() * i / threadCount;
+		size_t last = tiles.size() * (i + 1) / threadCount;
+
+		std::lock_guard<std::mutex> lock(queues[i]->mutex);
+		queues[i]->tiles.assign(tiles.begin() + first, tiles.begin() + last);
+	}
+
+	Clock::time_point start = Clock::now();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	this->work = &work;
+	error = nullptr;
+	failed = false;
+	finishedWorkers = 0;
+	generation++;
+	runStarted.notify_all();
+
+	runFinished.wait(lock, [&]() { return finishedWorkers == threadCount; });
+	this->work = nullptr;
+
+	// Whatever time a worker didn't spend on tiles, it spent looking for work
+	// or waiting for the others to finish
+	stats.wallMilliseconds = Milliseconds(Clock::now() - start);
+	for (WorkerStats& worker : stats.workers)
+		worker.idleMilliseconds = std::max(0.0, stats.wallMilliseconds - worker.busyMilliseconds);
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void TileScheduler::WorkerLoop(uint32_t index)
+{
+	uint64_t lastGeneration = 0;
+
+	while (true)
+	{
+		const std::function<void(const Tile&)>* currentWork;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			runStarted.wait(lock, [&]() { return shutdown || generation != lastGeneration; });
+
+			if (shutdown)
+				return;
+
+			lastGeneration = generation;
+			currentWork = work;
+		}
+
+		// Only this thread touches its own stats while a run is going on
+		WorkerStats& workerStats = stats.workers[index];
+		workerStats = WorkerStats{ 0, 0, 0.0, 0.0 };
+
+		Tile tile;
+		bool stolen;
+		while (PopTile(index, tile, stolen))
+		{
+			// After a failure the remaining tiles are only drained
+			if (failed)
+				continue;
+
+			Clock::time_point tileStart = Clock::now();
+			try
+			{
+				(*currentWork)(tile);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error)
+					error = std::current_exception();
+
+				failed = true;
+			}
+
+			workerStats.busyMilliseconds += Milliseconds(Clock::now() - tileStart);
+			workerStats.tilesProcessed++;
+			if (stolen)
+				workerStats.tilesStolen++;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finishedWorkers++;
+		}
+		runFinished.notify_one();
+	}
+}
+
+bool TileScheduler::PopTile(uint32_t index, Tile& tile, bool& stolen)
+{
+	// Take work from the front of our own queue first
+	{
+		WorkerQueue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tiles.empty())
+		{
+			tile = own.tiles.front();
+			own.tiles.pop_front();
+			stolen = false;
+			return true;
+		}
+	}
+
+	// Then steal from the back of the others. Tiles are never added during
+	// a run, so once every queue is empty there is nothing left to do.
+	uint32_t threadCount = GetThreadCount();
+	for (uint32_t offset = 1; offset < threadCount; offset++)
+	{
+		WorkerQueue& victim = *queues[(index + offset) % threadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tiles.empty())
+		{
+			tile = victim.tiles.back();
+			victim.tiles.pop_back();
+			stolen = true;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Tile.hpp"
+
+struct WorkerStats
+{
+	uint64_t tilesProcessed;
+	uint64_t tilesStolen;
+	double busyMilliseconds;
+	double idleMilliseconds;
+};
+
+struct SchedulerStats
+{
+	double wallMilliseconds;
+	std::vector<WorkerStats> workers;
+};
+
+// Runs work on the tiles of an image using a pool of persistent threads.
+// Every worker starts with a contiguous block of tiles in its own deque,
+// and steals from the back of the other deques once its own ran dry. This
+// keeps all threads busy even if some tiles are much more expensive than
+// others, e.g. the interior of a connected Julia set.
+class TileScheduler
+{
+public:
+	// A thread count of 0 uses every hardware thread
+	TileScheduler(uint32_t threadCount = 0);
+	~TileScheduler();
+
+	// Splits the image into tiles of tileSize x tileSize pixels and calls
+	// work once per tile. work is called from several threads at once.
+	// Blocks until every tile was processed, and rethrows the first
+	// exception thrown by work.
+	void Run(uint32_t width, uint32_t height, uint32_t tileSize, const std::function<void(const Tile&)>& work);
+
+	// Same as above, but only covers the given regions of the image
+	void Run(const std::vector<Tile>& regions, uint32_t tileSize, const std::function<void(const Tile&)>& work);
+
+	inline uint32_t GetThreadCount() const { return (uint32_t)workers.size(); }
+
+	// Statistics of the last call to Run()
+	inline const SchedulerStats& GetStats() const { return stats; }
+
+private:
+	void WorkerLoop(uint32_t index);
+	bool PopTile(uint32_t index, Tile& tile, bool& stolen);
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Tile> tiles;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+	// Protects everything below, and is used to hand out new runs
+	std::mutex mutex;
+	std::condition_variable runStarted, runFinished;
+	uint64_t generation;
+	uint32_t finishedWorkers;
+	bool shutdown;
+
+	const std::function<void(const Tile&)>* work;
+	std::exception_ptr error;
+	std::atomic<bool> failed;
+
+	SchedulerStats stats;
+};
@@ -0,0 +1,207 @@
+#include "TiledExport.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "Image.hpp"
+
+static const char Magic[8] = { 'J', 'U', 'L', 'I', 'A', 'T', 'I', 'L' };
+static const uint32_t Version = 1;
+
+static void PushLittleEndian(std::vector<uint8_t>& data, uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		data.push_back((uint8_t)(value >> (8 * i)));
+}
+
+// FNV-1a over everything that changes the pixels, so a resumed export can't
+// mix tiles of different images. That includes the engine and its settings.
+static uint64_t Fingerprint(const CpuEngine& engine, const JuliaProperties& properties, const TiledExportSettings& settings)
+{
+	std::ostringstream description;
+	description.precision(17);
+	description << engine.GetDescription() << " " << properties.xBounds[0] << " " << properties.xBounds[1] << " " << properties.yCenter << " "
+		<< properties.maxIterations << " " << properties.iterationColorCutoff << " " << properties.palette << " "
+		<< properties.c[0] << " " << properties.c[1] << " " << (int)properties.precision << " "
+		<< properties.isPolar << " " << properties.periodicityCheck << " "
+		<< settings.width << " " << settings.height << " " << settings.tileSize;
+
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : description.str())
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+TiledExportStats ExportTiled(CpuEngine& engine, const JuliaProperties& properties, const TiledExportSettings& settings, const std::string& path)
+{
+	auto wallStart = std::chrono::steady_clock::now();
+
+	if (settings.width == 0 || settings.height == 0 || settings.tileSize == 0)
+		throw std::runtime_error("Tiled export needs a non-zero image and tile size");
+
+	if (!engine.IsTileLocal())
+		throw std::runtime_error(std::string("Tiled export doesn't work with ") + engine.GetName() + " in this configuration");
+
+	uint64_t tilesX64 = (settings.width + settings.tileSize - 1) / settings.tileSize;
+	uint64_t tilesY64 = (settings.height + settings.tileSize - 1) / settings.tileSize;
+	if (tilesX64 * tilesY64 > 0xFFFFFFFFull)
+		throw std::runtime_error("Too many tiles, use a larger tile size");
+
+	uint32_t tilesX = (uint32_t)tilesX64;
+	uint32_t tilesY = (uint32_t)tilesY64;
+	uint32_t tileCount = tilesX * tilesY;
+
+	auto tileWidth = [&](uint32_t tx) { return (uint32_t)std::min<uint64_t>(settings.tileSize, settings.width - (uint64_t)tx * settings.tileSize); };
+	auto tileHeight = [&](uint32_t ty) { return (uint32_t)std::min<uint64_t>(settings.tileSize, settings.height - (uint64_t)ty * settings.tileSize); };
+
+	// Header and index, the offsets are known up front
+	uint64_t fingerprint = Fingerprint(engine, properties, settings);
+	std::vector<uint8_t> header(Magic, Magic + 8);
+	PushLittleEndian(header, Version, 4);
+	PushLittleEndian(header, settings.tileSize, 4);
+	PushLittleEndian(header, settings.width, 8);
+	PushLittleEndian(header, settings.height, 8);
+	PushLittleEndian(header, fingerprint, 8);
+	PushLittleEndian(header, tilesX, 4);
+	PushLittleEndian(header, tilesY, 4);
+
+	std::vector<uint64_t> offsets(tileCount);
+	uint64_t offset = header.size() + (uint64_t)tileCount * 16;
+	for (uint32_t ty = 0; ty < tilesY; ty++)
+	{
+		for (uint32_t tx = 0; tx < tilesX; tx++)
+		{
+			offsets[ty * tilesX + tx] = offset;
+			PushLittleEndian(header, offset, 8);
+			PushLittleEndian(header, tileWidth(tx), 4);
+			PushLittleEndian(header, tileHeight(ty), 4);
+			offset += (uint64_t)tileWidth(tx) * tileHeight(ty) * 3;
+		}
+	}
+
+	// Resume if the file was started with the same header and a journal
+	// says which tiles made it
+	std::string journalPath = path + ".journal";
+	std::vector<uint8_t> done(tileCount, 0);
+	bool resume = false;
+	{
+		std::ifstream existing(path, std::ios::binary);
+		std::ifstream journal(journalPath, std::ios::binary);
+		if (existing && journal)
+		{
+			std::vector<uint8_t> existingHeader(header.size());
+			existing.read((char*)existingHeader.data(), (std::streamsize)existingHeader.size());
+			resume = existing && existingHeader == header;
+
+			uint8_t entry[4];
+			while (resume && journal.read((char*)entry, 4))
+			{
+				uint32_t index = entry[0] | (entry[1] << 8) | (entry[2] << 16) | ((uint32_t)entry[3] << 24);
+				if (index < tileCount)
+					done[index] = 1;
+			}
+		}
+	}
+
+	std::fstream file;
+	if (resume)
+	{
+		file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+	}
+	else
+	{
+		std::fill(done.begin(), done.end(), 0);
+		file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+		file.write((const char*)header.data(), (std::streamsize)header.size());
+
+		std::ofstream(journalPath, std::ios::binary | std::ios::trunc);
+	}
+
+	if (!file)
+		throw std::runtime_error("Failed to open " + path + " for writing");
+
+	std::ofstream journal(journalPath, std::ios::binary | std::ios::app);
+	if (!journal)
+		throw std::runtime_error("Failed to open " + journalPath + " for writing");
+
+	TiledExportStats stats = {};
+	stats.tileCount = tileCount;
+
+	// Square pixels, the whole image is centered on the view of the
+	// properties
+	double pixelSize = (properties.xBounds[1] - properties.xBounds[0]) / settings.width;
+	double xMin = properties.xBounds[0];
+	double yMin = properties.yCenter - 0.5 * settings.height * pixelSize;
+
+	std::vector<uint8_t> rgb, rows;
+	for (uint32_t ty = 0; ty < tilesY; ty++)
+	{
+		for (uint32_t tx = 0; tx < tilesX; tx++)
+		{
+			uint32_t index = ty * tilesX + tx;
+			if (done[index])
+			{
+				stats.resumedTiles++;
+				continue;
+			}
+
+			uint32_t width = tileWidth(tx);
+			uint32_t height = tileHeight(ty);
+
+			// Tile rows count from the top, the engines count from yMin
+			uint64_t left = (uint64_t)tx * settings.tileSize;
+			uint64_t bottom = settings.height - (uint64_t)ty * settings.tileSize - height;
+
+			JuliaProperties tile = properties;
+			tile.textureWidth = width;
+			tile.xBounds[0] = xMin + left * pixelSize;
+			tile.xBounds[1] = xMin + (left + width) * pixelSize;
+			tile.yCenter = yMin + (bottom + 0.5 * height) * pixelSize;
+
+			// The engines derive the height from the aspect ratio, which has
+			// to round to exactly the tile height
+			tile.aspectRatio = (float)height / width;
+			while ((uint32_t)(width * tile.aspectRatio) < height)
+				tile.aspectRatio = std::nextafter(tile.aspectRatio, 2.0f * tile.aspectRatio);
+
+			engine.CalculateJuliaSet(tile);
+			if (engine.GetWidth() != width || engine.GetHeight() != height)
+				throw std::runtime_error("Engine returned a tile of the wrong size");
+
+			ColorizeIterations(tile, engine.GetIterations(), rgb);
+
+			// Flip to top to bottom
+			rows.resize(rgb.size());
+			for (uint32_t y = 0; y < height; y++)
+				std::copy_n(&rgb[(size_t)(height - 1 - y) * width * 3], (size_t)width * 3, &rows[(size_t)y * width * 3]);
+
+			file.seekp((std::streamoff)offsets[index]);
+			file.write((const char*)rows.data(), (std::streamsize)rows.size());
+			file.flush();
+			if (!file)
+				throw std::runtime_error("Failed to write " + path);
+
+			// Only recorded once the data is out of our buffers
+			uint8_t entry[4] = { (uint8_t)index, (uint8_t)(index >> 8), (uint8_t)(index >> 16), (uint8_t)(index >> 24) };
+			journal.write((const char*)entry, 4);
+			journal.flush();
+		}
+	}
+
+	// The image is complete, nothing to resume anymore
+	journal.close();
+	std::remove(journalPath.c_str());
+
+	stats.wallMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+	return stats;
+}
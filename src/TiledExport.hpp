@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "CpuEngine.hpp"
+#include "JuliaProperties.hpp"
+
+// Renders images too large for memory tile by tile into a raw tiled file.
+// Only one tile is held in memory at a time, whatever the image size.
+//
+// File layout, all numbers little endian:
+//   char[8]  "JULIATIL"
+//   uint32   version (1)
+//   uint32   tile size
+//   uint64   width, height
+//   uint64   fingerprint of the engine and properties the image was rendered with
+//   uint32   tiles in x, tiles in y
+//   per tile: uint64 offset, uint32 width, uint32 height
+//   tile data: 8 bit RGB, rows top to bottom
+// Tiles are listed row by row starting at the top left. Tiles on the right
+// and bottom edges are smaller if the image size isn't a multiple of the
+// tile size.
+//
+// Finished tiles are recorded in "<path>.journal". If an export with the
+// same engine and properties is started again, the tiles listed there are skipped.
+// The journal is removed once every tile is written.
+
+struct TiledExportSettings
+{
+	uint64_t width, height;
+	uint32_t tileSize;
+};
+
+struct TiledExportStats
+{
+	uint32_t tileCount;
+
+	// Tiles that a previous, interrupted export had finished already
+	uint32_t resumedTiles;
+	double wallMilliseconds;
+};
+
+// The view, c, palette and so on come from the properties, but the image
+// size from the settings. Pixels are square, so the height of the view
+// follows from its width and the aspect ratio of the image. Throws if the
+// engine isn't tile local.
+TiledExportStats ExportTiled(CpuEngine& engine, const JuliaProperties& properties, const TiledExportSettings& settings, const std::string& path);